@@ -7,8 +7,15 @@
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glob.h>
+#include <pwd.h>
 
-#define HISTORY_LEN 60  // 保存 60 个点
+#define HISTORY_TIERS 3 // 历史数据的分辨率层数
 
 typedef struct {
     char model[128];
@@ -22,6 +29,7 @@ typedef struct {
 typedef struct {
     long long mem_total;
     long long mem_free;
+    long long mem_available;
     long long buffers;
     long long cached;
     long long swap_total;
@@ -35,43 +43,269 @@ typedef struct {
     long long sunreclaim;
 } MemStat;
 
+// /proc/stat 一行 cpu 的各个字段
+enum {
+    CPU_USER,
+    CPU_NICE,
+    CPU_SYSTEM,
+    CPU_IDLE,
+    CPU_IOWAIT,
+    CPU_IRQ,
+    CPU_SOFTIRQ,
+    CPU_STEAL,
+    CPU_FIELDS
+};
+
 typedef struct {
+    long long f[CPU_FIELDS];
     long long total;
-    long long idle;
+    long long idle;             // idle + iowait
 } CpuTotal;
 
+// 每核计数按字段分开存放：f[字段][核]，差值循环只在连续数组上做逐元素运算，便于编译器向量化
+typedef struct {
+    int n;                      // 核数（最大编号 + 1）
+    int cap;
+    long long* f[CPU_FIELDS];
+} CoreCounters;
+
+// /proc/diskstats 中一个整盘设备的累计计数。
+// 快照和设备选择只保留按名字排序的前 DISK_MAX_DEVS 个，合计覆盖全部设备
+#define DISK_MAX_DEVS 16
+#define DISK_NAME_MAX 32
+
 typedef struct {
-    long long sectors;
-} DiskTotal;
+    char name[DISK_NAME_MAX];
+    unsigned long long rd_ios, rd_sectors, rd_ms;
+    unsigned long long wr_ios, wr_sectors, wr_ms;
+    unsigned long long in_flight;
+    unsigned long long io_ticks;    // 有请求在处理的毫秒数
+    int stacked;
+} DiskCounters;
 
 typedef struct {
     long long utime, stime;
+    long long sys_total;        // 上次采样时的系统 CPU 总时间，跳过若干轮后差值仍然正确
 } ProcCpu;
 
 typedef struct {
     long long read_bytes, write_bytes;
+    gint64 time_us;             // 上次采样时刻，速率按实际间隔计算
 } ProcIO;
 
 typedef struct {
-    double cpu[HISTORY_LEN];
-    double mem[HISTORY_LEN];
-    double disk[HISTORY_LEN];
-    int index; // 下一个写入位置
-} PerfData;
+    char name[128];
+    char state;
+    int ppid;
+    long long utime, stime;
+    unsigned long long starttime;
+    long long rss_pages;
+    int processor;              // 最近一次运行的 CPU，只有线程 stat 会解析，否则为 -1
+} ProcStat;
+
+// 一层环形历史，每个点是一个时间桶的 min/avg/max
+typedef struct {
+    int bucket_secs;            // 每个点覆盖的秒数
+    int capacity;
+    int count;                  // 已有的点数
+    int head;                   // 下一个写入位置
+    double* min;
+    double* avg;
+    double* max;
+
+    gint64 bucket;              // 正在累计的桶编号
+    int acc_n;
+    double acc_sum;
+    double acc_min;
+    double acc_max;
+
+    guint64 pushed;             // 累计写入的点数，绘图缓存据此判断要滚动几步
+} HistoryTier;
+
+typedef struct {
+    HistoryTier tiers[HISTORY_TIERS];
+} MetricHistory;
+
+// 压力信息（PSI）：/proc/pressure/* 和 cgroup 的 *.pressure 格式相同
+enum {
+    PSI_CPU,
+    PSI_MEM,
+    PSI_IO,
+    PSI_RES
+};
+
+typedef struct {
+    double avg10, avg60, avg300;    // 百分比
+    long long total;                // 累计停顿微秒
+} PsiLine;
+
+typedef struct {
+    PsiLine some;                   // 至少一个任务在等待
+    PsiLine full;                   // 所有非空闲任务都在等待
+    int ok;
+} PsiStat;
+
+// 网络：/proc/net/dev 每个接口一行，接口数有上限，计数和速率都放在定长数组里
+#define NET_MAX_IFACES 32
+#define NET_NAME_MAX 16
+
+typedef struct {
+    char name[NET_NAME_MAX];
+    unsigned long long rx_bytes, rx_packets, rx_errs, rx_drop;
+    unsigned long long tx_bytes, tx_packets, tx_errs, tx_drop;
+} NetDevCounters;
+
+typedef struct {
+    char name[NET_NAME_MAX];
+    double rx_kb, tx_kb;            // KB/s
+    double rx_pps, tx_pps;          // 包/s
+    double errs_ps, drop_ps;        // 收发合计的错误、丢包速率
+    unsigned long long errs, drops; // 累计值
+} NetRate;
+
+// /proc/net/snmp 里 "Tcp:" 两行中用到的字段
+typedef struct {
+    long long active_opens;
+    long long passive_opens;
+    long long curr_estab;
+    long long in_segs;
+    long long out_segs;
+    long long retrans_segs;
+    long long in_errs;
+} TcpStat;
+
+typedef struct {
+    MetricHistory cpu;
+    MetricHistory mem;
+    MetricHistory disk;
+    MetricHistory psi[PSI_RES];     // 每轮 some 停顿时间占比
+    MetricHistory net;              // 除 lo 外所有接口的收发合计
+    MetricHistory* disk_dev[DISK_MAX_DEVS];     // 每个磁盘的读写合计，第一次见到设备时分配
+    char disk_dev_name[DISK_MAX_DEVS][DISK_NAME_MAX];
+    guint epoch;                // 每次重置加一
+} PerfHistory;
 
 typedef enum {
     PERF_CPU,
     PERF_MEM,
-    PERF_DISK
+    PERF_DISK,
+    PERF_PSI_CPU,
+    PERF_PSI_MEM,
+    PERF_PSI_IO,
+    PERF_NET,
+    PERF_TYPES
 } PerfType;
 
 typedef struct {
-    unsigned long long read_sectors;
-    unsigned long long write_sectors;
-    unsigned long long busy_time;
-} DiskStats;
+    char name[DISK_NAME_MAX];
+    int stacked;                // dm/md 等叠加在其他磁盘上的设备，不计入合计
+    double read_iops, write_iops;
+    double read_kb, write_kb;
+    double read_lat_ms, write_lat_ms;   // 本轮完成的请求平均耗时
+    double in_flight;           // 正在处理的请求数
+    double busy;                // 活动时间百分比
+} DiskRate;
+
+// 每轮只读一次 /proc/stat、/proc/meminfo、/proc/diskstats，差值也只算一次，所有面板共用
+typedef struct {
+    CpuTotal cpu;
+    MemStat mem;
+    int mem_ok;
+    int disk_ok;
+
+    gint64 time_us;             // 读 /proc/stat 的时刻（单调时钟）
+    double elapsed_s;           // 与上一轮的实际间隔，所有速率都按它归一化
+    long long cpu_total_diff;   // 与上一轮的 CPU 总时间差，进程 CPU% 也以它为分母
+    double cpu_p;               // 系统总 CPU 占用
+    double cpu_split[CPU_FIELDS]; // 各字段占总时间的百分比
+    int n_cores;
+    float* core_usage;          // 每核占用百分比，随快照一起还给 core_usage 池
+    int core_usage_cap;
+    double mem_p;               // 系统总内存占用
+    double disk_kb;             // 系统总磁盘速率
+    int n_disks;
+    DiskRate disks[DISK_MAX_DEVS];  // 按设备名排序
+    DiskRate disk_total;        // 非叠加设备的合计，活动时间取最忙的设备
+    PsiStat psi[PSI_RES];
+    double psi_some_p[PSI_RES]; // 本轮 some/full 停顿时间占实际间隔的百分比
+    double psi_full_p[PSI_RES];
+    int n_net;
+    NetRate net[NET_MAX_IFACES];    // 接口顺序与 /proc/net/dev 一致
+    double net_rx_kb;               // 除 lo 外的合计
+    double net_tx_kb;
+    TcpStat tcp;
+    int tcp_ok;
+    double tcp_retrans_ps;
+    double tcp_retrans_p;           // 本轮重传段占发送段的百分比
+} SystemSnapshot;
+
+typedef struct {
+    int pid;
+    char name[128];
+    double cpu;
+    double mem;
+    double io_kb;
+    guint32 key_off;        // 搜索键在 Snapshot.keys 中的偏移
+    int ppid;               // 回放的录制文件里没有，为 0
+} ProcRow;
 
-DiskStats last_disk_stats = { 0 };
+typedef struct {
+    int tid;
+    char name[64];
+    char state;
+    int last_cpu;           // 最近一次运行的 CPU
+    double cpu;
+} ThreadRow;
+
+// 一个 cgroup 的统计，数值直接读自 cgroup 文件，不从进程累加
+#define CGROUP_PATH_MAX 256
+typedef struct {
+    char path[CGROUP_PATH_MAX]; // 相对 cgroup 根目录，根为 "/"
+    double cpu;                 // 与进程 CPU% 同一口径，100% 为整机
+    long long mem_bytes;        // memory.current，没有该文件时为 0
+    long long anon_bytes;       // memory.stat 的 anon / file
+    long long file_bytes;
+    double read_kb;             // io.stat 各设备合计，KB/s
+    double write_kb;
+    long long pids;             // pids.current
+} CgroupRow;
+
+// 采集线程每个周期生成一份快照，交给主线程后只读
+typedef struct {
+    gint64 time_us;         // 采样时刻（单调时钟）
+    gint64 wall_us;         // 采样时刻（墙上时间）
+    int seq;                // 回放中的记录下标，实时采集为 -1
+    int discontinuous;      // 回放跳转后与上一份快照不连续，历史需要重置
+    GArray* procs;          // ProcRow 数组，本轮没有扫描进程时为 NULL
+    GString* keys;          // 各进程的搜索键，与 procs 同时存在
+    int thread_pid;         // threads 所属的进程
+    GArray* threads;        // ThreadRow 数组，线程视图没有展开时为 NULL
+    GArray* cgroups;        // CgroupRow 数组，cgroup 页不可见时为 NULL
+    char cgroup_psi_path[CGROUP_PATH_MAX];  // cgroup 页选中的组，没有选中为空
+    PsiStat cgroup_psi[PSI_RES];
+    SystemSnapshot sys;
+    CpuInfo cpu_info;
+
+    long fd_saved;          // fd 缓存本轮省下的系统调用数
+    int fd_open;            // fd 缓存当前打开的 fd 数
+    int tracks_live;        // 进程增量状态条目数
+    int tracks_pooled;      // 已分配的条目总数（含空闲）
+    gint64 scan_us;         // 进程扫描耗时
+    gint64 jitter_us;       // 本轮开始时刻比预定时刻晚了多少
+    gint64 jitter_p99_us;   // 最近 SCHED_JITTER_WINDOW 轮的 p99
+    int scan_workers;       // 本轮参与扫描的线程数
+} Snapshot;
+
+// 搜索键：小写的 "pid\x1fname\x1fuser\x1fcgroup\x1fcmdline"，每个快照采集时生成一次
+#define KEY_SEP '\x1f'
+enum {
+    KEY_PID,
+    KEY_NAME,
+    KEY_USER,
+    KEY_CGROUP,
+    KEY_CMDLINE,
+    KEY_FIELDS
+};
 
 enum {
     COL_PID,
@@ -84,41 +318,124 @@ enum {
 
 PerfType current_perf = PERF_CPU;
 
-PerfData perf_data = { {0}, {0}, {0}, 0 };
+PerfHistory perf_history;
+static int perf_zoom = 0;        // 当前缩放级别，zoom_levels 的下标
+GtkWidget* history_mem_label;    // 历史数据内存占用
+GtkWidget* sample_jitter_label;  // 实际采样间隔和抖动
 GtkWidget* perf_stack;
 GtkWidget* perf_drawing_area;
 GtkWidget* perf_cpu_label;
 GtkWidget* perf_mem_label;
 GtkWidget* perf_disk_label;
 GtkWidget* cpu_drawing_area;
+GtkWidget* cpu_core_area;       // 每核网格
+GtkWidget* cpu_split_label;     // 用户/系统/IO 等待/中断/窃取
 GtkWidget* mem_drawing_area;
 GtkWidget* disk_drawing_area;
+GtkWidget* perf_psi_label;
+GtkWidget* psi_drawing_area[PSI_RES];
+GtkWidget* psi_info_label[PSI_RES];
+GtkWidget* perf_net_label;
+GtkWidget* net_drawing_area;
+GtkWidget* net_iface_area;      // 每个接口一行数字加收发小图
+GtkWidget* net_tcp_label;
+static const char* psi_titles[PSI_RES] = { "CPU", "内存", "I/O" };
 
 /* ================= 全局变量 ================= */
-GtkListStore* store;//读到的进程数据
 GtkCellRendererText* renderers[NUM_COLS]; // 保存每列的渲染器
+GtkTreeViewColumn* columns[NUM_COLS];     // 进程列表的列
+GtkWidget* column_menu;                   // 列标题右键菜单
 GtkWidget* process_panel_box;  // 放在 Stack 中的进程面板 Box
 GtkWidget* process_tree_view;  // 进程列表 TreeView
 GtkWidget* performance_panel;  // 性能面板
 GtkWidget* search_entry;       // 搜索框
-GtkTreeModelFilter* filter_model; // 过滤模型
-GtkTreeModelSort* sort_model;     // 排序模型
-GHashTable* cpu_table;
-GHashTable* io_table;
+GtkWidget* thread_expander;    // 线程视图
+GtkWidget* thread_tree_view;
+GtkListStore* thread_store;
+
+enum {
+    TCOL_TID,
+    TCOL_NAME,
+    TCOL_STATE,
+    TCOL_LAST_CPU,
+    TCOL_CPU,
+    NUM_TCOLS
+};
+
+GtkWidget* cgroup_tree_view;   // cgroup 页
+GtkWidget* cgroup_label;
+GtkWidget* cgroup_psi_label;   // 选中组的压力信息
+GtkListStore* cgroup_store;
+
+enum {
+    CGCOL_PATH,
+    CGCOL_CPU,
+    CGCOL_MEM,          // MB
+    CGCOL_ANON,
+    CGCOL_FILE,
+    CGCOL_READ,         // KB/s
+    CGCOL_WRITE,
+    CGCOL_PIDS,
+    NUM_CGCOLS
+};
 
+GtkWidget* sys_label;//系统状态标签
 GtkWidget* cpu_detail_label;//cpu详细信息标签
 GtkWidget* mem_info_label = NULL;//内存详细信息标签
 GtkWidget* disk_read_label;
 GtkWidget* disk_write_label;
 GtkWidget* disk_active_label;
+GtkWidget* disk_combo;         // 磁盘设备选择
+static char disk_selected[DISK_NAME_MAX];  // 选中的设备名，空串表示全部磁盘
 
 
 int is_selection = 0;//是否保持选中
 static int current_sort_col = COL_PID;   // 当前排序列
 static int selected_pid = -1;            // 选中进程pid
-static int flash_time = 1;               // 刷新时间 单位秒
+static double flash_time = 1.0;          // 刷新时间 单位秒，最小 0.1
 static char search_text[128] = "";       // 搜索文本框
 
+// 搜索条件按空格拆成若干项，全部匹配才显示；"field:value" 只在该字段里找
+#define SEARCH_MAX_TERMS 8
+#define SEARCH_DEBOUNCE_MS 150
+#define SEARCH_ANY (-1)
+typedef struct {
+    int field;              // KEY_* 或 SEARCH_ANY
+    char text[128];         // 小写
+    int len;
+} SearchTerm;
+static SearchTerm search_terms[SEARCH_MAX_TERMS];
+static int n_search_terms = 0;
+static guint search_timeout = 0;
+static const char* key_field_names[KEY_FIELDS] = { "pid", "name", "user", "cg", "cmd" };
+
+// 进程采集需要额外读取的文件，由主线程根据可见列设置
+enum {
+    PROC_NEED_IO = 1 << 0,  // /proc/PID/io，Disk 列
+};
+static gint proc_need_mask = PROC_NEED_IO;
+static gint thread_pid = -1;    // 线程视图要显示的进程，由主线程设置，-1 表示不扫描线程
+
+// 本轮采集哪些内容
+enum {
+    COLLECT_PROCS = 1 << 0,     // 扫描 /proc/PID
+    COLLECT_CPU_INFO = 1 << 1,  // 解析 /proc/cpuinfo 和频率
+    COLLECT_CGROUPS = 1 << 2,   // 遍历 /sys/fs/cgroup
+    COLLECT_ALL = COLLECT_PROCS | COLLECT_CPU_INFO,
+};
+
+// 当前可见的内容，由主线程维护、采集线程读取
+enum {
+    VIEW_MAPPED = 1 << 0,       // 窗口已显示且没有最小化
+    VIEW_FOCUSED = 1 << 1,
+    VIEW_PROCESS = 1 << 2,      // 进程页
+    VIEW_PERF_CPU = 1 << 3,     // 性能页的 CPU 子页
+    VIEW_CGROUP = 1 << 4,       // cgroup 页
+    VIEW_ALL = VIEW_MAPPED | VIEW_FOCUSED | VIEW_PROCESS | VIEW_PERF_CPU,  // 不含 cgroup 页：无界面和录制都不输出 cgroup
+};
+GtkWidget* main_window;
+GtkWidget* main_stack;
+
 
 double cpu_p = 0.0; //当前cpu的总占用
 double disk_kb = 0.0;//当前磁盘的总占用
@@ -134,1122 +451,6440 @@ int is_pid_dir(const char* name)
     return 1;
 }
 
-void get_process_name(const char* pid, char* buf, size_t size) 
+void on_row_selected(GtkTreeView* treeview, gpointer user_data)
 {
-    char path[256];
-    snprintf(path, sizeof(path), "/proc/%s/comm", pid);
-    FILE* fp = fopen(path, "r");
-    if (!fp) {
-        strncpy(buf, "unknown", size);
-        return;
-    }
-    fgets(buf, size, fp);
-    buf[strcspn(buf, "\n")] = 0;
-    fclose(fp);
+    is_selection = 1; // 允许 update_process_list 保持选中
 }
 
-void on_row_selected(GtkTreeView* treeview, gpointer user_data)
+/* ================= 进程搜索 ================= */
+// 生成一个进程的搜索键，追加到 out 末尾（含结尾的 '\0'）
+void search_key_append(GString* out, int pid, const char* name, const char* user,
+    const char* cgroup, const char* cmdline)
 {
-    is_selection = 1; // 允许 update_process_list 保持选中
+    const char* fields[KEY_FIELDS] = { NULL, name, user, cgroup, cmdline };
+    g_string_append_printf(out, "%d", pid);
+    for (int f = KEY_NAME; f < KEY_FIELDS; f++) {
+        g_string_append_c(out, KEY_SEP);
+        for (const char* p = fields[f] ? fields[f] : ""; *p; p++)
+            g_string_append_c(out, *p == KEY_SEP ? ' ' : g_ascii_tolower(*p));
+    }
+    g_string_append_c(out, '\0');
 }
 
-/* 搜索框逻辑 */
-void on_search_changed(GtkEntry* entry, gpointer user_data) 
+// 解析搜索框文本，不认识的 "xxx:" 前缀按普通文本处理
+void search_compile(const char* text)
 {
-    const char* text = gtk_entry_get_text(entry);
-    g_strlcpy(search_text, text, sizeof(search_text));
-    gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(filter_model));
+    gchar** words = g_strsplit_set(text, " \t", -1);
+    n_search_terms = 0;
+    for (int i = 0; words[i] && n_search_terms < SEARCH_MAX_TERMS; i++) {
+        const char* w = words[i];
+        if (*w == '\0') continue;
+
+        SearchTerm* t = &search_terms[n_search_terms];
+        t->field = SEARCH_ANY;
+        const char* colon = strchr(w, ':');
+        for (int f = 0; colon && f < KEY_FIELDS; f++) {
+            if ((size_t)(colon - w) == strlen(key_field_names[f]) &&
+                g_ascii_strncasecmp(w, key_field_names[f], colon - w) == 0) {
+                t->field = f;
+                w = colon + 1;
+                break;
+            }
+        }
+        if (*w == '\0') continue;
+
+        g_strlcpy(t->text, w, sizeof(t->text));
+        for (char* p = t->text; *p; p++) *p = g_ascii_tolower(*p);
+        t->len = (int)strlen(t->text);
+        n_search_terms++;
+    }
+    g_strfreev(words);
 }
 
-/* ================= 点击效果 ================= */
-gboolean filter_visible_func(GtkTreeModel* model, GtkTreeIter* iter, gpointer data) 
+// cg:PATH 按路径分量做前缀匹配，cg:/a 匹配 /a 和 /a/b，不匹配 /ab；开头的 '/' 可以省略
+static int cgroup_prefix_match(const char* start, const char* end, const char* text, int len)
 {
-    if (search_text[0] == '\0') return TRUE;
+    int field_len = end ? (int)(end - start) : (int)strlen(start);
+    if (len > 0 && text[0] != '/' && field_len > 0 && start[0] == '/') {
+        start++;
+        field_len--;
+    }
+    if (len > field_len || memcmp(start, text, len) != 0) return 0;
+    return len == field_len || start[len] == '/' || (len > 0 && text[len - 1] == '/');
+}
 
-    char buf[128] = { 0 };
+// 不区分大小写的子串匹配；pid:N 要求 PID 完全相等，cg:PATH 按路径前缀匹配
+int search_match(const char* key)
+{
+    for (int i = 0; i < n_search_terms; i++) {
+        const SearchTerm* t = &search_terms[i];
+        if (t->field == SEARCH_ANY) {
+            if (!strstr(key, t->text)) return 0;
+            continue;
+        }
 
-    if (current_sort_col == COL_NAME)//名字字符串模糊搜索
-    {
-        gchar* name = NULL;
-        gtk_tree_model_get(model, iter, COL_NAME, &name, -1);
+        const char* start = key;
+        for (int f = 0; f < t->field && start; f++) {
+            start = strchr(start, KEY_SEP);
+            if (start) start++;
+        }
+        if (!start) return 0;
+        const char* end = strchr(start, KEY_SEP);
 
-        if (name) {
-            g_strlcpy(buf, name, sizeof(buf));
-            g_free(name);
+        if (t->field == KEY_PID) {
+            if (end - start != t->len || memcmp(start, t->text, t->len) != 0) return 0;
+        }
+        else if (t->field == KEY_CGROUP) {
+            if (!cgroup_prefix_match(start, end, t->text, t->len)) return 0;
         }
         else {
-            buf[0] = '\0';
+            // 第一次出现的位置超出字段末尾，说明字段内没有
+            const char* hit = strstr(start, t->text);
+            if (!hit || (end && hit + t->len > end)) return 0;
         }
     }
+    return 1;
+}
 
-    else if (current_sort_col == COL_PID) //pid整形模糊搜索
-    {
-        int pid;
-        gtk_tree_model_get(model, iter, COL_PID, &pid, -1);
-        snprintf(buf, sizeof(buf), "%d", pid);
-    }
-    else //cpu,mem,io浮点模糊搜索
-    {
-        double val;
-        gtk_tree_model_get(model, iter, current_sort_col, &val, -1);
-        snprintf(buf, sizeof(buf), "%.2f", val);
-    }
+/* ================= 进程列表模型 ================= */
+// 进程数据按列存放，过滤和排序只生成一个下标排列 view，不经过 ListStore/Filter/Sort 三层。
+// TreeView 通过 GtkTreeModel 接口按需读取屏幕上的行；数据更新时只通知行数变化，其余交给重绘。
+#define PROC_TYPE_MODEL (proc_model_get_type())
+G_DECLARE_FINAL_TYPE(ProcModel, proc_model, PROC, MODEL, GObject)
+
+struct _ProcModel {
+    GObject parent_instance;
+    int stamp;                  // 数据或顺序每变化一次加一，旧 iter 随之失效
+    guint n_rows;
+    guint cap;
+
+    int* pid;
+    int* ppid;
+    double* val[NUM_COLS];      // 只有 COL_CPU..COL_DISK 有数据
+    double* total[NUM_COLS];    // 树状视图下的子树合计
+    guint32* name_off;          // names 中的偏移
+    guint32* key_off;           // keys 中的偏移
+    guint8* match;              // 是否匹配当前搜索条件
+    guint8* show;               // 树状视图下是否显示：自身匹配或有匹配的子孙
+    GString* names;
+    GString* keys;
+
+    guint* view;                // 显示位置 -> 行下标
+    guint n_view;
+    guint* view_tmp;            // 基数排序、树展开的暂存区
+    guint64* sort_key;
+    guint64* sort_tmp;
+
+    int sort_col;
+    GtkSortType sort_order;
+    int tree_mode;              // 按父子关系显示，数值列为子树合计
+};
 
-    return g_strrstr(buf, search_text) != NULL;
-}
+static void proc_model_tree_model_init(GtkTreeModelIface* iface);
+static void proc_model_sortable_init(GtkTreeSortableIface* iface);
 
-// stack切换
-gboolean on_stack_row_clicked(GtkWidget* widget, GdkEventButton* event, gpointer user_data)
+G_DEFINE_TYPE_WITH_CODE(ProcModel, proc_model, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, proc_model_tree_model_init)
+    G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_SORTABLE, proc_model_sortable_init))
+
+ProcModel* proc_model;
+
+static void proc_model_init(ProcModel* m)
 {
-    gpointer* data = (gpointer*)user_data;
-    GtkWidget* stack = GTK_WIDGET(data[0]);
-    const char* name = (const char*)data[1];
+    m->stamp = g_random_int();
+    m->names = g_string_new(NULL);
+    m->keys = g_string_new(NULL);
+    m->sort_col = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+    m->sort_order = GTK_SORT_ASCENDING;
+}
 
-    gtk_stack_set_visible_child_name(GTK_STACK(stack), name);
-    return TRUE;
+static void proc_model_finalize(GObject* obj)
+{
+    ProcModel* m = PROC_MODEL(obj);
+    g_free(m->pid);
+    g_free(m->ppid);
+    for (int c = COL_CPU; c < NUM_COLS; c++) {
+        g_free(m->val[c]);
+        g_free(m->total[c]);
+    }
+    g_free(m->name_off);
+    g_free(m->key_off);
+    g_free(m->match);
+    g_free(m->show);
+    g_free(m->view);
+    g_free(m->view_tmp);
+    g_free(m->sort_key);
+    g_free(m->sort_tmp);
+    g_string_free(m->names, TRUE);
+    g_string_free(m->keys, TRUE);
+    G_OBJECT_CLASS(proc_model_parent_class)->finalize(obj);
 }
 
-// 创建可点击行
-GtkWidget* create_clickable_row(const char* text, GtkWidget* stack, const char* stack_name)
+static void proc_model_class_init(ProcModelClass* klass)
 {
-    GtkWidget* label = gtk_label_new(text);
-    gtk_widget_set_halign(label, GTK_ALIGN_START);
-    gtk_widget_set_margin_start(label, 5);
-    gtk_widget_set_margin_top(label, 5);
+    G_OBJECT_CLASS(klass)->finalize = proc_model_finalize;
+}
 
-    GtkWidget* box = gtk_event_box_new(); // EventBox 让 Label 可点击
-    gtk_container_add(GTK_CONTAINER(box), label);
+static void proc_model_reserve(ProcModel* m, guint n)
+{
+    if (n <= m->cap) return;
+    m->cap = MAX(n, MAX(m->cap * 2, 256));
+    m->pid = g_renew(int, m->pid, m->cap);
+    m->ppid = g_renew(int, m->ppid, m->cap);
+    for (int c = COL_CPU; c < NUM_COLS; c++) {
+        m->val[c] = g_renew(double, m->val[c], m->cap);
+        m->total[c] = g_renew(double, m->total[c], m->cap);
+    }
+    m->name_off = g_renew(guint32, m->name_off, m->cap);
+    m->key_off = g_renew(guint32, m->key_off, m->cap);
+    m->match = g_renew(guint8, m->match, m->cap);
+    m->show = g_renew(guint8, m->show, m->cap);
+    m->view = g_renew(guint, m->view, m->cap);
+    m->view_tmp = g_renew(guint, m->view_tmp, m->cap);
+    m->sort_key = g_renew(guint64, m->sort_key, m->cap);
+    m->sort_tmp = g_renew(guint64, m->sort_tmp, m->cap);
+}
 
-    // 用数组传递 stack 和 name
-    gpointer* data = g_new(gpointer, 2);
-    data[0] = stack;
-    data[1] = (gpointer)stack_name;
+// double 的位模式变换成保持大小顺序的无符号整数
+static inline guint64 sort_key_double(double v)
+{
+    guint64 u;
+    memcpy(&u, &v, sizeof(u));
+    return (u >> 63) ? ~u : u | (1ULL << 63);
+}
 
-    g_signal_connect(box, "button-press-event",
-        G_CALLBACK(on_stack_row_clicked),
-        data);
+// 按 sort_key 对 view 做 LSD 基数排序（稳定），所有行该字节都相同的轮次直接跳过
+static void proc_model_radix_sort(ProcModel* m)
+{
+    guint n = m->n_view;
+    guint64* k = m->sort_key;
+    guint64* kt = m->sort_tmp;
+    guint* v = m->view;
+    guint* vt = m->view_tmp;
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        guint count[256] = { 0 };
+        for (guint i = 0; i < n; i++)
+            count[(k[i] >> shift) & 0xff]++;
+        if (count[(k[0] >> shift) & 0xff] == n) continue;
+
+        guint sum = 0;
+        for (int d = 0; d < 256; d++) {
+            guint c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+        for (guint i = 0; i < n; i++) {
+            guint p = count[(k[i] >> shift) & 0xff]++;
+            kt[p] = k[i];
+            vt[p] = v[i];
+        }
 
-    return box;
+        guint64* tk = k; k = kt; kt = tk;
+        guint* tv = v; v = vt; vt = tv;
+    }
+    if (v != m->view)
+        memcpy(m->view, v, n * sizeof(guint));
 }
 
-void on_kill_task_clicked(GtkButton* button, gpointer user_data) 
-{ 
-    if (selected_pid <= 0) 
-    { 
-        GtkWidget* dlg = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_WARNING, GTK_BUTTONS_OK, "请先选择一个进程");
-        gtk_dialog_run(GTK_DIALOG(dlg));
-        gtk_widget_destroy(dlg); return; } 
-    if (kill(selected_pid, SIGTERM) == 0) 
-    {
-        g_print("已向 PID %d 发送 SIGTERM\n", selected_pid); 
-    } 
-    else 
-    { 
-        GtkWidget* dlg = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_ERROR, GTK_BUTTONS_OK, "无法结束该进程（权限不足或受保护进程）");
-        gtk_dialog_run(GTK_DIALOG(dlg)); gtk_widget_destroy(dlg);
-    } 
+// 当前显示的数值列：树状视图下是子树合计
+static inline const double* proc_model_col(const ProcModel* m, int col)
+{
+    return m->tree_mode ? m->total[col] : m->val[col];
 }
 
-void column_clicked(GtkTreeViewColumn* col, gpointer user_data) 
+// 比较两行，相等时按 PID；未排序时只按 PID
+static gint proc_model_compare_rows(gconstpointer a, gconstpointer b, gpointer data)
 {
-    int col_index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(col), "col_index"));
-    current_sort_col = col_index;
+    const ProcModel* m = data;
+    guint i = *(const guint*)a, j = *(const guint*)b;
+    int col = m->sort_col;
+    int r = 0;
+    if (col == COL_NAME) {
+        r = strcmp(m->names->str + m->name_off[i], m->names->str + m->name_off[j]);
+    }
+    else if (col >= COL_CPU) {
+        const double* v = proc_model_col(m, col);
+        r = (v[i] > v[j]) - (v[i] < v[j]);
+    }
+    if (r == 0) r = (m->pid[i] > m->pid[j]) - (m->pid[i] < m->pid[j]);
+    return (col >= 0 && m->sort_order == GTK_SORT_DESCENDING) ? -r : r;
+}
 
-    is_selection = 0; // 禁止刷新保持选中
-    selected_pid = -1;
+// 数值列用基数排序，名字用 qsort；相等的行保持采集顺序
+static void proc_model_sort(ProcModel* m)
+{
+    int col = m->sort_col;
+    if (col < 0 || m->n_view < 2) return;
 
-    if (filter_model) 
-    {
-        gtk_tree_model_filter_refilter(GTK_TREE_MODEL_FILTER(filter_model));
+    if (col == COL_NAME) {
+        g_qsort_with_data(m->view, m->n_view, sizeof(guint), proc_model_compare_rows, m);
+        return;
     }
 
-    for (int i = 0; i < NUM_COLS; i++) 
-    {
-        GdkRGBA color;
-        if (i == col_index)
-            gdk_rgba_parse(&color, "#e0e0e0"); // 选中列
-        else
-            gdk_rgba_parse(&color, "white");
-        g_object_set(renderers[i], "cell-background-rgba", &color, NULL);
+    guint64 flip = m->sort_order == GTK_SORT_DESCENDING ? ~0ULL : 0;
+    for (guint i = 0; i < m->n_view; i++) {
+        guint r = m->view[i];
+        guint64 key = col == COL_PID ? (guint64)(guint32)m->pid[r] : sort_key_double(proc_model_col(m, col)[r]);
+        m->sort_key[i] = key ^ flip;
     }
+    proc_model_radix_sort(m);
 }
 
-void on_perf_row_selected(GtkListBox* box, GtkListBoxRow* row, gpointer data)//性能面板不同类型选中逻辑
+/* ---- 进程树 ---- */
+// 节点按 PID 常驻，每轮只把变化量沿祖先链加上去，不做整树遍历重算。
+// 合计用千分之一为单位的整数保存，反复加减不会积累浮点误差。
+#define TREE_VALS 3         // CPU、MEM、Disk，对应 COL_CPU..COL_DISK
+
+typedef struct ProcNode {
+    int pid;
+    guint gen;
+    guint row;                  // 本轮在 ProcModel 中的行下标
+    int depth;                  // 展开后的缩进层级
+    gint64 self[TREE_VALS];
+    gint64 total[TREE_VALS];    // 含所有子孙
+    struct ProcNode* parent;
+    struct ProcNode* first_child;
+    struct ProcNode* prev_sibling;
+    struct ProcNode* next_sibling;
+} ProcNode;
+
+static GHashTable* proc_nodes;      // pid -> ProcNode
+static GHashTable* collapsed_pids;  // 折叠的节点，刷新后保持
+static ProcNode** row_nodes;        // 行下标 -> 节点
+static guint row_nodes_cap;
+static guint tree_gen;
+static GArray* tree_siblings;       // 排序同一层兄弟节点的暂存区
+
+static inline gint64 to_milli(double v)
 {
-    if (!row) return;
+    return (gint64)(v * 1000.0 + (v >= 0 ? 0.5 : -0.5));
+}
 
-    int type = GPOINTER_TO_INT(
-        g_object_get_data(G_OBJECT(row), "perf_type"));
+// 从 p 开始沿祖先链累加 sign * d
+static void proc_node_propagate(ProcNode* p, const gint64* d, int sign)
+{
+    for (; p; p = p->parent)
+        for (int k = 0; k < TREE_VALS; k++)
+            p->total[k] += sign * d[k];
+}
 
-    switch (type) {
-    case PERF_CPU:
-        current_perf = PERF_CPU;
-        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "cpu");
-        break;
-    case PERF_MEM:
-        current_perf = PERF_MEM;
-        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "mem");
-        break;
-    case PERF_DISK:
-        current_perf = PERF_DISK;
-        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "disk");
-        break;
-    }
+static void proc_node_detach(ProcNode* n)
+{
+    ProcNode* p = n->parent;
+    if (!p) return;
+    proc_node_propagate(p, n->total, -1);
+    if (n->prev_sibling) n->prev_sibling->next_sibling = n->next_sibling;
+    else p->first_child = n->next_sibling;
+    if (n->next_sibling) n->next_sibling->prev_sibling = n->prev_sibling;
+    n->parent = n->prev_sibling = n->next_sibling = NULL;
 }
 
+// parent 为 NULL 或者会形成环（PID 复用时可能出现）时作为根节点
+static void proc_node_attach(ProcNode* n, ProcNode* parent)
+{
+    for (ProcNode* a = parent; a; a = a->parent)
+        if (a == n) return;
+    if (!parent) return;
+
+    n->parent = parent;
+    n->prev_sibling = NULL;
+    n->next_sibling = parent->first_child;
+    if (parent->first_child) parent->first_child->prev_sibling = n;
+    parent->first_child = n;
+    proc_node_propagate(parent, n->total, 1);
+}
 
-/* ================= 系统 CPU ================= */
-CpuTotal get_cpu_total()
+void proc_tree_reset()
 {
-    FILE* fp = fopen("/proc/stat", "r");
-    CpuTotal c = { 0 };
-    if (!fp) return c;
+    if (proc_nodes) g_hash_table_remove_all(proc_nodes);
+}
 
-    char line[256];
-    if (fgets(line, sizeof(line), fp)) {
-        long long user, nice, sys, idle, iowait, irq, softirq, steal;
-        int n = sscanf(line,
-            "cpu %lld %lld %lld %lld %lld %lld %lld %lld",
-            &user, &nice, &sys, &idle,
-            &iowait, &irq, &softirq, &steal);
+// 用模型中本轮的行更新进程树，并把子树合计写入 m->total
+static void proc_tree_update(ProcModel* m)
+{
+    if (!proc_nodes) {
+        proc_nodes = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+        collapsed_pids = g_hash_table_new(g_direct_hash, g_direct_equal);
+        tree_siblings = g_array_new(FALSE, FALSE, sizeof(guint));
+    }
+    if (m->n_rows > row_nodes_cap) {
+        row_nodes_cap = m->cap;
+        row_nodes = g_renew(ProcNode*, row_nodes, row_nodes_cap);
+    }
+    tree_gen++;
+
+    // 1. 找到或新建每一行的节点；新节点合计为 0，挂到哪里都不影响祖先
+    for (guint r = 0; r < m->n_rows; r++) {
+        ProcNode* n = g_hash_table_lookup(proc_nodes, GINT_TO_POINTER(m->pid[r]));
+        if (!n) {
+            n = g_new0(ProcNode, 1);
+            n->pid = m->pid[r];
+            g_hash_table_insert(proc_nodes, GINT_TO_POINTER(n->pid), n);
+        }
+        n->gen = tree_gen;
+        n->row = r;
+        row_nodes[r] = n;
+    }
 
-        if (n >= 7) {
-            c.idle = idle + (n > 4 ? iowait : 0);
-            c.total = user + nice + sys + c.idle +
-                (n > 5 ? irq : 0) +
-                (n > 6 ? softirq : 0) +
-                (n > 7 ? steal : 0);
+    // 2. 父进程变了（退出后被收养）才移动子树
+    for (guint r = 0; r < m->n_rows; r++) {
+        ProcNode* n = row_nodes[r];
+        ProcNode* p = m->ppid[r] > 0 ? g_hash_table_lookup(proc_nodes, GINT_TO_POINTER(m->ppid[r])) : NULL;
+        if (p && p->gen != tree_gen) p = NULL;
+        if (n->parent != p) {
+            proc_node_detach(n);
+            proc_node_attach(n, p);
         }
     }
-    fclose(fp);
-    return c;
+
+    // 3. 自身数值的变化量沿祖先链累加
+    for (guint r = 0; r < m->n_rows; r++) {
+        ProcNode* n = row_nodes[r];
+        gint64 d[TREE_VALS];
+        int changed = 0;
+        for (int k = 0; k < TREE_VALS; k++) {
+            gint64 v = to_milli(m->val[COL_CPU + k][r]);
+            d[k] = v - n->self[k];
+            n->self[k] = v;
+            changed |= d[k] != 0;
+        }
+        if (changed) proc_node_propagate(n, d, 1);
+    }
+
+    // 4. 删除已退出的进程，还挂在下面的子进程先变成根节点
+    GHashTableIter hi;
+    gpointer value;
+    g_hash_table_iter_init(&hi, proc_nodes);
+    while (g_hash_table_iter_next(&hi, NULL, &value)) {
+        ProcNode* n = value;
+        if (n->gen == tree_gen) continue;
+        while (n->first_child)
+            proc_node_detach(n->first_child);
+        proc_node_detach(n);
+        g_hash_table_remove(collapsed_pids, GINT_TO_POINTER(n->pid));
+        g_hash_table_iter_remove(&hi);
+    }
+
+    for (guint r = 0; r < m->n_rows; r++)
+        for (int k = 0; k < TREE_VALS; k++)
+            m->total[COL_CPU + k][r] = row_nodes[r]->total[k] / 1000.0;
 }
 
-void get_cpu_info(CpuInfo* info)
+// 把同一层的行排好序后倒序压栈，出栈顺序即显示顺序
+static void proc_tree_push(ProcModel* m, guint* stack, guint* sp, int depth)
 {
-    FILE* fp = fopen("/proc/cpuinfo", "r");
-    if (!fp) {
-        strcpy(info->model, "unknown");
-        info->cores = 0;
-        info->threads = 0;
-        info->cache_kb = 0;
-        info->freq_ghz = 0.0;
-        return;
+    GArray* sib = tree_siblings;
+    if (sib->len > 1)
+        g_qsort_with_data(sib->data, sib->len, sizeof(guint), proc_model_compare_rows, m);
+    for (guint k = sib->len; k > 0; k--) {
+        guint r = g_array_index(sib, guint, k - 1);
+        row_nodes[r]->depth = depth;
+        stack[(*sp)++] = r;
     }
+    g_array_set_size(sib, 0);
+}
 
-    char line[256];
-    info->cores = 0;
-    info->threads = 0;
-    info->cache_kb = 0;
-    info->model[0] = '\0';
-
-    while (fgets(line, sizeof(line), fp)) {
-        if (strncmp(line, "model name", 10) == 0 && info->model[0] == '\0') {
-            char* p = strchr(line, ':');
-            if (p) {
-                p += 2;
-                strncpy(info->model, p, sizeof(info->model) - 1);
-                info->model[strcspn(info->model, "\n")] = 0;
-            }
-        }
-        else if (strncmp(line, "cpu cores", 9) == 0 && info->cores == 0) {
-            int cores = 0;
-            sscanf(line, "cpu cores\t: %d", &cores);
-            info->cores = cores;
-        }
-        else if (strncmp(line, "processor", 9) == 0) {
-            info->threads++;
-        }
-        else if (strncmp(line, "cache size", 10) == 0 && info->cache_kb == 0) {
-            int cache = 0;
-            sscanf(line, "cache size\t: %d", &cache);
-            info->cache_kb = cache;
+// 深度优先生成 view，折叠的节点不展开；搜索时显示匹配的行和它们的祖先
+static void proc_tree_flatten(ProcModel* m)
+{
+    memcpy(m->show, m->match, m->n_rows);
+    if (n_search_terms > 0) {
+        for (guint r = 0; r < m->n_rows; r++) {
+            if (!m->match[r]) continue;
+            for (ProcNode* p = row_nodes[r]->parent; p && !m->show[p->row]; p = p->parent)
+                m->show[p->row] = 1;
         }
     }
-    fclose(fp);
 
-    // ----- 频率读取 fallback -----
+    guint* stack = m->view_tmp;
+    guint sp = 0;
+    guint n = 0;
+    gboolean any_collapsed = g_hash_table_size(collapsed_pids) > 0;
+
+    for (guint r = 0; r < m->n_rows; r++)
+        if (!row_nodes[r]->parent && m->show[r])
+            g_array_append_val(tree_siblings, r);
+    proc_tree_push(m, stack, &sp, 0);
+
+    while (sp > 0) {
+        guint r = stack[--sp];
+        ProcNode* node = row_nodes[r];
+        m->view[n++] = r;
+        if (!node->first_child) continue;
+        if (any_collapsed && g_hash_table_contains(collapsed_pids, GINT_TO_POINTER(node->pid))) continue;
+
+        for (ProcNode* c = node->first_child; c; c = c->next_sibling)
+            if (m->show[c->row])
+                g_array_append_val(tree_siblings, c->row);
+        proc_tree_push(m, stack, &sp, node->depth + 1);
+    }
+    m->n_view = n;
+}
 
-    long freq = 0;
+// 展开/折叠 pid 的子树，没有子进程时返回 FALSE
+gboolean proc_tree_toggle(int pid)
+{
+    ProcNode* n = proc_nodes ? g_hash_table_lookup(proc_nodes, GINT_TO_POINTER(pid)) : NULL;
+    if (!n || !n->first_child) return FALSE;
+    if (!g_hash_table_remove(collapsed_pids, GINT_TO_POINTER(pid)))
+        g_hash_table_add(collapsed_pids, GINT_TO_POINTER(pid));
+    return TRUE;
+}
 
-    // ① scaling_cur_freq
-    fp = fopen("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "r");
-    if (fp) {
-        fscanf(fp, "%ld", &freq);
-        fclose(fp);
-        info->freq_ghz = freq / 1000000.0;
+// 按 match 重新生成 view 并排序
+static void proc_model_rebuild_view(ProcModel* m)
+{
+    if (m->tree_mode) {
+        proc_tree_flatten(m);
+        m->stamp++;
         return;
     }
+    guint n = 0;
+    for (guint r = 0; r < m->n_rows; r++)
+        if (m->match[r]) m->view[n++] = r;
+    m->n_view = n;
+    proc_model_sort(m);
+    m->stamp++;
+}
 
-    // ② cpuinfo_cur_freq
-    fp = fopen("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_cur_freq", "r");
-    if (fp) {
-        fscanf(fp, "%ld", &freq);
-        fclose(fp);
-        info->freq_ghz = freq / 1000000.0;
-        return;
-    }
-
-    // ③ /proc/cpuinfo 的 cpu MHz
-    fp = fopen("/proc/cpuinfo", "r");
-    if (fp) {
-        while (fgets(line, sizeof(line), fp)) {
-            if (sscanf(line, "cpu MHz\t: %ld", &freq) == 1) {
-                info->freq_ghz = freq / 1000.0;
-                fclose(fp);
-                return;
-            }
-        }
-        fclose(fp);
+// 用快照替换全部数据，返回替换前显示的行数
+guint proc_model_set_rows(ProcModel* m, const Snapshot* s)
+{
+    guint old_n = m->n_view;
+    guint n = s->procs->len;
+    proc_model_reserve(m, n);
+
+    g_string_truncate(m->names, 0);
+    g_string_truncate(m->keys, 0);
+    g_string_append_len(m->keys, s->keys->str, s->keys->len);
+
+    for (guint i = 0; i < n; i++) {
+        const ProcRow* row = &g_array_index(s->procs, ProcRow, i);
+        m->pid[i] = row->pid;
+        m->ppid[i] = row->ppid;
+        m->val[COL_CPU][i] = row->cpu;
+        m->val[COL_MEM][i] = row->mem;
+        m->val[COL_DISK][i] = row->io_kb;
+        m->name_off[i] = (guint32)m->names->len;
+        g_string_append_len(m->names, row->name, strlen(row->name) + 1);
+        m->key_off[i] = row->key_off;
+        m->match[i] = search_match(m->keys->str + row->key_off);
     }
-
-    // fallback
-    info->freq_ghz = 0.0;
+    m->n_rows = n;
+    if (m->tree_mode) proc_tree_update(m);
+    proc_model_rebuild_view(m);
+    return old_n;
 }
 
-
-/* ================= 系统内存 ================= */
-long long get_mem_total_kb() 
+// 搜索条件变化后重新过滤，返回之前显示的行数
+guint proc_model_refilter(ProcModel* m)
 {
-    FILE* fp = fopen("/proc/meminfo", "r");
-    if (!fp) return 0;
-    char line[128];
-    long long total = 0;
-    while (fgets(line, sizeof(line), fp)) {
-        if (sscanf(line, "MemTotal: %lld kB", &total) == 1)
-            break;
-    }
-    fclose(fp);
-    return total;
+    guint old_n = m->n_view;
+    for (guint r = 0; r < m->n_rows; r++)
+        m->match[r] = search_match(m->keys->str + m->key_off[r]);
+    proc_model_rebuild_view(m);
+    return old_n;
 }
 
-double get_mem_percent() 
+guint proc_model_clear(ProcModel* m)
 {
-    FILE* fp = fopen("/proc/meminfo", "r");
-    if (!fp) return 0.0;
-
-    long long total = 0, avail = 0;
-    char line[128], key[64];
-    long long val;
-
-    while (fgets(line, sizeof(line), fp)) {
-        if (sscanf(line, "%63s %lld kB", key, &val) != 2) continue;
-        if (strcmp(key, "MemTotal:") == 0) total = val;
-        else if (strcmp(key, "MemAvailable:") == 0) avail = val;
-    }
-    fclose(fp);
-    return total ? 100.0 * (total - avail) / total : 0.0;
+    guint old_n = m->n_view;
+    m->n_rows = 0;
+    m->n_view = 0;
+    m->stamp++;
+    return old_n;
 }
 
-int get_mem_stat(MemStat* m)
+// 切换平铺/树状显示，返回之前显示的行数
+guint proc_model_set_tree_mode(ProcModel* m, gboolean on)
 {
-    FILE* fp = fopen("/proc/meminfo", "r");
-    if (!fp) return 0;
-
-    char key[64];
-    long long value;
-    char unit[32];
-
-    memset(m, 0, sizeof(MemStat));
-
-    while (fscanf(fp, "%63s %lld %31s", key, &value, unit) == 3)
-    {
-        if (strcmp(key, "MemTotal:") == 0) m->mem_total = value;
-        else if (strcmp(key, "MemFree:") == 0) m->mem_free = value;
-        else if (strcmp(key, "Buffers:") == 0) m->buffers = value;
-        else if (strcmp(key, "Cached:") == 0) m->cached = value;
-        else if (strcmp(key, "SwapTotal:") == 0) m->swap_total = value;
-        else if (strcmp(key, "SwapFree:") == 0) m->swap_free = value;
-        else if (strcmp(key, "Active:") == 0) m->active = value;
-        else if (strcmp(key, "Inactive:") == 0) m->inactive = value;
-        else if (strcmp(key, "Slab:") == 0) m->slab = value;
-        else if (strcmp(key, "Shmem:") == 0) m->shmem = value;
-        else if (strcmp(key, "SReclaimable:") == 0) m->sreclaimable = value;
-        else if (strcmp(key, "SUnreclaim:") == 0) m->sunreclaim = value;
-    }
-
-    fclose(fp);
-    return 1;
+    guint old_n = m->n_view;
+    m->tree_mode = on;
+    proc_tree_reset();
+    if (on) proc_tree_update(m);
+    proc_model_rebuild_view(m);
+    return old_n;
 }
 
-/* ================= 系统磁盘 ================= */
-DiskTotal get_disk_total() 
+// 返回 pid 的显示位置，不在列表中返回 -1
+int proc_model_find_pid(const ProcModel* m, int pid)
 {
-    FILE* fp = fopen("/proc/diskstats", "r");
-    DiskTotal d = { 0 };
-    if (!fp) return d;
+    for (guint i = 0; i < m->n_view; i++)
+        if (m->pid[m->view[i]] == pid) return (int)i;
+    return -1;
+}
 
-    char line[256];
-    while (fgets(line, sizeof(line), fp)) 
-    {
-        int major = 0, minor = 0;
-        char name[32] = { 0 };
-        long long tmp1, tmp2, rd_sectors, tmp4, tmp5, tmp6, wr_sectors, tmp8;
-        if (sscanf(line, "%d %d %31s %lld %lld %lld %lld %lld %lld %lld %lld",
-            &major, &minor, name, &tmp1, &tmp2, &rd_sectors, &tmp4,
-            &tmp5, &tmp6, &wr_sectors, &tmp8) != 11)
-            continue;
-        if (strncmp(name, "sd", 2) == 0 || strncmp(name, "nvme", 4) == 0)
-            d.sectors += rd_sectors + wr_sectors;
+// 只在末尾补发插入/删除信号让 TreeView 的行数对上，行内容靠重绘时重新读取
+void proc_model_emit_resize(ProcModel* m, guint old_n)
+{
+    GtkTreeModel* model = GTK_TREE_MODEL(m);
+    for (guint i = old_n; i > m->n_view; i--) {
+        GtkTreePath* path = gtk_tree_path_new_from_indices(i - 1, -1);
+        gtk_tree_model_row_deleted(model, path);
+        gtk_tree_path_free(path);
+    }
+    for (guint i = old_n; i < m->n_view; i++) {
+        GtkTreeIter iter = { m->stamp, GUINT_TO_POINTER(i) };
+        GtkTreePath* path = gtk_tree_path_new_from_indices(i, -1);
+        gtk_tree_model_row_inserted(model, path, &iter);
+        gtk_tree_path_free(path);
     }
-    fclose(fp);
-    return d;
 }
 
-/* ================= 进程 CPU ================= */
-int get_proc_cpu(int pid, ProcCpu* pc) 
+/* ---- GtkTreeModel 接口 ---- */
+static GtkTreeModelFlags proc_model_get_flags(GtkTreeModel* model)
 {
-    char path[128], buf[512];
-    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
-    FILE* fp = fopen(path, "r");
-    if (!fp) return 0;
-    if (!fgets(buf, sizeof(buf), fp)) { fclose(fp); return 0; }
-    fclose(fp);
-
-    char comm[256], state;
-    sscanf(buf, "%*d %s %c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lld %lld",
-        comm, &state, &pc->utime, &pc->stime);
-    return 1;
+    return GTK_TREE_MODEL_LIST_ONLY;
 }
 
-/* ================= 进程内存 ================= */
-double get_proc_mem(int pid, long long mem_total) 
+static gint proc_model_get_n_columns(GtkTreeModel* model)
 {
-    char path[128], line[128];
-    snprintf(path, sizeof(path), "/proc/%d/status", pid);
-    FILE* fp = fopen(path, "r");
-    if (!fp) return 0.0;
-
-    long long rss = 0;
-    while (fgets(line, sizeof(line), fp)) {
-        if (sscanf(line, "VmRSS: %lld kB", &rss) == 1) break;
-    }
-    fclose(fp);
-    return mem_total ? 100.0 * rss / mem_total : 0.0;
+    return NUM_COLS;
 }
 
-/* ================= 进程 I/O ================= */
-int get_proc_io(int pid, ProcIO* io) 
+static GType proc_model_get_column_type(GtkTreeModel* model, gint col)
 {
-    char path[128], line[128];
-    snprintf(path, sizeof(path), "/proc/%d/io", pid);
-    FILE* fp = fopen(path, "r");
-    if (!fp) return 0;
-
-    io->read_bytes = io->write_bytes = 0;
-    while (fgets(line, sizeof(line), fp)) 
-    {
-        long long tmp;
-        if (sscanf(line, "read_bytes: %lld", &tmp) == 1) io->read_bytes = tmp;
-        if (sscanf(line, "write_bytes: %lld", &tmp) == 1) io->write_bytes = tmp;
+    switch (col) {
+    case COL_PID:  return G_TYPE_INT;
+    case COL_NAME: return G_TYPE_STRING;
+    default:       return G_TYPE_DOUBLE;
     }
-    fclose(fp);
-    return 1;
 }
 
-/* ================= 排序函数 ================= */
-gint sort_func(GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer data) 
+static gboolean proc_model_iter_at(ProcModel* m, GtkTreeIter* iter, gint pos)
 {
-    int col = GPOINTER_TO_INT(data);
-    double va, vb;
-    gtk_tree_model_get(model, a, col, &va, -1);
-    gtk_tree_model_get(model, b, col, &vb, -1);
-    if (va < vb) return 1;
-    if (va > vb) return -1;
-    return 0;
+    if (pos < 0 || (guint)pos >= m->n_view) return FALSE;
+    iter->stamp = m->stamp;
+    iter->user_data = GINT_TO_POINTER(pos);
+    return TRUE;
 }
 
-gint sort_name_func(GtkTreeModel* model, GtkTreeIter* a, GtkTreeIter* b, gpointer data) 
+static gboolean proc_model_get_iter(GtkTreeModel* model, GtkTreeIter* iter, GtkTreePath* path)
 {
-    gchar* name_a; gchar* name_b;
-    gtk_tree_model_get(model, a, COL_NAME, &name_a, -1);
-    gtk_tree_model_get(model, b, COL_NAME, &name_b, -1);
-    gint ret = g_strcmp0(name_a, name_b);
-    g_free(name_a); g_free(name_b);
-    return ret;
+    if (gtk_tree_path_get_depth(path) != 1) return FALSE;
+    return proc_model_iter_at(PROC_MODEL(model), iter, gtk_tree_path_get_indices(path)[0]);
 }
 
-/* ================= 绘图函数 ================= */
-void draw_perf_line(cairo_t* cr, double* data_array, int start, int len,int h, double dx, double r, double g, double b, double scale)
+static GtkTreePath* proc_model_get_path(GtkTreeModel* model, GtkTreeIter* iter)
 {
-    cairo_save(cr);
-    cairo_move_to(cr, 0, h);
-    for (int i = 0; i < len; i++) 
-    {
-        int idx = (start + i) % len;
-        double y = h * (1.0 - data_array[idx] / scale);
-        if (y < 0) y = 0;
-        cairo_line_to(cr, i * dx, y);
-    }
-    cairo_line_to(cr, (len - 1) * dx, h);
-    cairo_line_to(cr, 0, h);
-    cairo_close_path(cr);
-
-    cairo_pattern_t* pat = cairo_pattern_create_linear(0, 0, 0, h);
-    cairo_pattern_add_color_stop_rgba(pat, 0.0, r, g, b, 0.40); // 顶部alpha
-    cairo_pattern_add_color_stop_rgba(pat, 1.0, r, g, b, 0.35); // 底部alpha
-    cairo_set_source(cr, pat);
-    cairo_fill(cr);
-    cairo_pattern_destroy(pat);
-    cairo_restore(cr);
-
-    cairo_set_source_rgb(cr, r, g, b);
-    cairo_move_to(cr, 0, h * (1.0 - data_array[start] / scale));
-    for (int i = 0; i < len; i++) {
-        int idx = (start + i) % len;
-        double y = h * (1.0 - data_array[idx] / scale);
-        if (y < 0) y = 0;
-        cairo_line_to(cr, i * dx, y);
-    }
-    cairo_stroke(cr);
+    return gtk_tree_path_new_from_indices(GPOINTER_TO_INT(iter->user_data), -1);
 }
 
-gboolean draw_performance(GtkWidget* widget, cairo_t* cr, gpointer data)
+static void proc_model_get_value(GtkTreeModel* model, GtkTreeIter* iter, gint col, GValue* value)
 {
-    int w = gtk_widget_get_allocated_width(widget);
-    int h = gtk_widget_get_allocated_height(widget);
-
-    /* ===== 背景 ===== */
-    cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
-    cairo_paint(cr);
-
-    double dx = (double)w / (HISTORY_LEN-2);
-    int start = (perf_data.index + 1) % HISTORY_LEN;
-
-    /* 线条更圆润 */
-    cairo_set_line_width(cr, 2.0);
-    cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
-    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
-
-    switch (current_perf) {
-    case PERF_CPU:
-        draw_perf_line(cr, perf_data.cpu, start, HISTORY_LEN, h, dx, 0.3, 0.6, 1.0, 100.0);
+    ProcModel* m = PROC_MODEL(model);
+    guint pos = GPOINTER_TO_UINT(iter->user_data);
+    g_return_if_fail(iter->stamp == m->stamp && pos < m->n_view);
+    guint r = m->view[pos];
+
+    switch (col) {
+    case COL_PID:
+        g_value_init(value, G_TYPE_INT);
+        g_value_set_int(value, m->pid[r]);
         break;
-    case PERF_MEM:
-        draw_perf_line(cr, perf_data.mem, start, HISTORY_LEN, h, dx, 0.05, 0.2, 0.6, 100.0);
+    case COL_NAME:
+        g_value_init(value, G_TYPE_STRING);
+        if (m->tree_mode) {
+            const ProcNode* n = row_nodes[r];
+            const char* mark = !n->first_child ? "  "
+                : g_hash_table_contains(collapsed_pids, GINT_TO_POINTER(n->pid)) ? "▸" : "▾";
+            g_value_take_string(value, g_strdup_printf("%*s%s %s", n->depth * 2, "", mark,
+                                                       m->names->str + m->name_off[r]));
+        }
+        else {
+            // 名字池在下次更新前不变，取值方会自行复制
+            g_value_set_static_string(value, m->names->str + m->name_off[r]);
+        }
         break;
-    case PERF_DISK:
-        draw_perf_line(cr, perf_data.disk, start, HISTORY_LEN, h, dx, 0.3, 0.8, 0.6, 1024.0);
+    default:
+        g_value_init(value, G_TYPE_DOUBLE);
+        g_value_set_double(value, proc_model_col(m, col)[r]);
         break;
     }
-
-    return FALSE;
 }
 
-/* ================= 进程列表更新 ================= */
-gboolean update_process_list(gpointer data)
+static gboolean proc_model_iter_next(GtkTreeModel* model, GtkTreeIter* iter)
 {
-    static CpuTotal prev_cpu = { 0 };
-
-    // 保存选中的 PID
-    if (is_selection)
-    {
-        GtkTreeSelection* selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(process_tree_view));
-        GtkTreeModel* model;
-        GtkTreeIter iter;
-        if (gtk_tree_selection_get_selected(selection, &model, &iter))
-        {
-            gtk_tree_model_get(model, &iter, COL_PID, &selected_pid, -1);
-        }
-    }
-    
-    
-
-    // 清空 ListStore
-    gtk_list_store_clear(store);
-
-    // 系统 CPU：计算总差值
-    CpuTotal cur_cpu = get_cpu_total();
-    long long total_diff = 0;
-
-    if (prev_cpu.total > 0)
-        total_diff = cur_cpu.total - prev_cpu.total;
+    return proc_model_iter_at(PROC_MODEL(model), iter, GPOINTER_TO_INT(iter->user_data) + 1);
+}
 
-    long long mem_total = get_mem_total_kb();
-    int ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+static gboolean proc_model_iter_previous(GtkTreeModel* model, GtkTreeIter* iter)
+{
+    return proc_model_iter_at(PROC_MODEL(model), iter, GPOINTER_TO_INT(iter->user_data) - 1);
+}
 
-    DIR* dir = opendir("/proc");
-    if (!dir) return TRUE;
+static gboolean proc_model_iter_children(GtkTreeModel* model, GtkTreeIter* iter, GtkTreeIter* parent)
+{
+    return parent ? FALSE : proc_model_iter_at(PROC_MODEL(model), iter, 0);
+}
 
-    struct dirent* e;
-    GtkTreeIter new_iter;
+static gboolean proc_model_iter_has_child(GtkTreeModel* model, GtkTreeIter* iter)
+{
+    return FALSE;
+}
 
-    while ((e = readdir(dir))) {
-        if (!is_pid_dir(e->d_name)) continue;
+static gint proc_model_iter_n_children(GtkTreeModel* model, GtkTreeIter* iter)
+{
+    return iter ? 0 : (gint)PROC_MODEL(model)->n_view;
+}
 
-        int pid = atoi(e->d_name);
-        char name[128];
-        get_process_name(e->d_name, name, sizeof(name));
+static gboolean proc_model_iter_nth_child(GtkTreeModel* model, GtkTreeIter* iter, GtkTreeIter* parent, gint n)
+{
+    return parent ? FALSE : proc_model_iter_at(PROC_MODEL(model), iter, n);
+}
 
-        // ---- CPU ----
-        ProcCpu pc;
-        if (!get_proc_cpu(pid, &pc)) continue;
+static gboolean proc_model_iter_parent(GtkTreeModel* model, GtkTreeIter* iter, GtkTreeIter* child)
+{
+    return FALSE;
+}
 
-        ProcCpu* prev = g_hash_table_lookup(cpu_table, GINT_TO_POINTER(pid));
-        double cpu = 0.0;
+static void proc_model_tree_model_init(GtkTreeModelIface* iface)
+{
+    iface->get_flags = proc_model_get_flags;
+    iface->get_n_columns = proc_model_get_n_columns;
+    iface->get_column_type = proc_model_get_column_type;
+    iface->get_iter = proc_model_get_iter;
+    iface->get_path = proc_model_get_path;
+    iface->get_value = proc_model_get_value;
+    iface->iter_next = proc_model_iter_next;
+    iface->iter_previous = proc_model_iter_previous;
+    iface->iter_children = proc_model_iter_children;
+    iface->iter_has_child = proc_model_iter_has_child;
+    iface->iter_n_children = proc_model_iter_n_children;
+    iface->iter_nth_child = proc_model_iter_nth_child;
+    iface->iter_parent = proc_model_iter_parent;
+}
 
-        if (prev && total_diff > 0) {
-            long long delta = (pc.utime + pc.stime) - (prev->utime + prev->stime);
-            cpu = (double)(delta) / total_diff * 100.0;
-            prev->utime = pc.utime;
-            prev->stime = pc.stime;
-        }
-        else {
-            ProcCpu* val = malloc(sizeof(ProcCpu));
-            *val = pc;
-            g_hash_table_insert(cpu_table, GINT_TO_POINTER(pid), val);
-            cpu = 0.0; // 第一次观察该进程时显示0
-        }
-
-        // ---- MEM ----
-        double mem = get_proc_mem(pid, mem_total);
-
-        // ---- IO ----
-        ProcIO io = { 0 };
-        double io_kb = 0.0;
-        if (get_proc_io(pid, &io)) {
-            ProcIO* prev_io = g_hash_table_lookup(io_table, GINT_TO_POINTER(pid));
-            if (prev_io) {
-                io_kb = ((io.read_bytes - prev_io->read_bytes) +
-                    (io.write_bytes - prev_io->write_bytes)) / 1024.0;
-                prev_io->read_bytes = io.read_bytes;
-                prev_io->write_bytes = io.write_bytes;
-            }
-            else {
-                ProcIO* val = malloc(sizeof(ProcIO));
-                *val = io;
-                g_hash_table_insert(io_table, GINT_TO_POINTER(pid), val);
-                io_kb = 0.0;
-            }
-        }
+/* ---- GtkTreeSortable 接口：只支持按列排序，不接受自定义比较函数 ---- */
+static gboolean proc_model_get_sort_column_id(GtkTreeSortable* sortable, gint* col, GtkSortType* order)
+{
+    ProcModel* m = PROC_MODEL(sortable);
+    if (col) *col = m->sort_col;
+    if (order) *order = m->sort_order;
+    return m->sort_col >= 0;
+}
 
-        // 添加到列表
-        gtk_list_store_append(store, &new_iter);
-        gtk_list_store_set(store, &new_iter,
-            COL_PID, pid,
-            COL_NAME, name,
-            COL_CPU, cpu,
-            COL_MEM, mem,
-            COL_DISK, io_kb,
-            -1);
+// 排序方式变化时发 rows-reordered，选中行跟着移动
+static void proc_model_set_sort_column_id(GtkTreeSortable* sortable, gint col, GtkSortType order)
+{
+    ProcModel* m = PROC_MODEL(sortable);
+    if (m->sort_col == col && m->sort_order == order) return;
+    m->sort_col = col;
+    m->sort_order = order;
+
+    guint n = m->n_view;
+    gint* old_pos = g_new(gint, MAX(m->n_rows, 1));
+    for (guint i = 0; i < n; i++)
+        old_pos[m->view[i]] = (gint)i;
+
+    proc_model_rebuild_view(m);
+
+    if (n > 0) {
+        gint* new_order = g_new(gint, n);
+        for (guint i = 0; i < n; i++)
+            new_order[i] = old_pos[m->view[i]];
+        GtkTreePath* path = gtk_tree_path_new();
+        gtk_tree_model_rows_reordered(GTK_TREE_MODEL(m), path, NULL, new_order);
+        gtk_tree_path_free(path);
+        g_free(new_order);
     }
+    g_free(old_pos);
+    gtk_tree_sortable_sort_column_changed(sortable);
+}
 
-    closedir(dir);
+static void proc_model_set_sort_func(GtkTreeSortable* sortable, gint col,
+    GtkTreeIterCompareFunc func, gpointer data, GDestroyNotify destroy)
+{
+    g_warning("ProcModel 不支持自定义排序函数");
+}
 
-    // ---- 恢复之前选中的行 ----
-    if (selected_pid != -1&& is_selection==1) 
-    {
-        GtkTreeIter store_iter;
-        gboolean valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(store), &store_iter);
-        while (valid) 
-        {
-            gint pid;
-            gtk_tree_model_get(GTK_TREE_MODEL(store), &store_iter, COL_PID, &pid, -1);
-
-            if (pid == selected_pid) 
-            {
-                GtkTreePath* filter_path = gtk_tree_model_filter_convert_child_path_to_path(GTK_TREE_MODEL_FILTER(filter_model),gtk_tree_model_get_path(GTK_TREE_MODEL(store), &store_iter));
-                GtkTreePath* sort_path = gtk_tree_model_sort_convert_child_path_to_path(GTK_TREE_MODEL_SORT(sort_model),filter_path);
-                if (sort_path) 
-                {
-                    GtkTreeSelection* sel = gtk_tree_view_get_selection(GTK_TREE_VIEW(process_tree_view));
-                    gtk_tree_selection_select_path(sel, sort_path);
-                    gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(process_tree_view), sort_path, NULL, FALSE, 0, 0);
-                    gtk_tree_path_free(sort_path);
-                }
-                gtk_tree_path_free(filter_path);
-                break;
-            }
-            valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(store), &store_iter);
-        }
-    }
-    prev_cpu = cur_cpu;
-    return TRUE;
+static void proc_model_set_default_sort_func(GtkTreeSortable* sortable,
+    GtkTreeIterCompareFunc func, gpointer data, GDestroyNotify destroy)
+{
+    g_warning("ProcModel 不支持自定义排序函数");
 }
 
-/* ================= 系统状态刷新 ================= */
-gboolean update_system_summary(gpointer user_data)
+static gboolean proc_model_has_default_sort_func(GtkTreeSortable* sortable)
 {
-    GtkWidget* sys_label = GTK_WIDGET(user_data);
+    return FALSE;
+}
 
-    static CpuTotal prev_cpu = { 0 };
-    static DiskTotal prev_disk = { 0 };
+static void proc_model_sortable_init(GtkTreeSortableIface* iface)
+{
+    iface->get_sort_column_id = proc_model_get_sort_column_id;
+    iface->set_sort_column_id = proc_model_set_sort_column_id;
+    iface->set_sort_func = proc_model_set_sort_func;
+    iface->set_default_sort_func = proc_model_set_default_sort_func;
+    iface->has_default_sort_func = proc_model_has_default_sort_func;
+}
 
-    CpuTotal cur_cpu = get_cpu_total();
-    DiskTotal cur_disk = get_disk_total();
+/* ================= 进程列表视图 ================= */
+#define PROC_VIEW_RESET_ROWS 4096   // 行数变化超过此数时重新挂载模型，比逐行发信号快
 
-    double cpu_p = 0.0, disk_kb = 0.0;
+// 模型数据已经替换，让 TreeView 的行数跟上并重绘可见部分
+void process_view_refresh(guint old_n)
+{
+    guint n = proc_model->n_view;
+    guint diff = n > old_n ? n - old_n : old_n - n;
 
-    if (prev_cpu.total > 0) {
-        long long total_diff = cur_cpu.total - prev_cpu.total;
-        long long idle_diff = cur_cpu.idle - prev_cpu.idle;
-        if (total_diff > 0)
-            cpu_p = 100.0 * (1.0 - (double)idle_diff / total_diff);
+    if (process_tree_view && diff > PROC_VIEW_RESET_ROWS) {
+        gtk_tree_view_set_model(GTK_TREE_VIEW(process_tree_view), NULL);
+        gtk_tree_view_set_model(GTK_TREE_VIEW(process_tree_view), GTK_TREE_MODEL(proc_model));
     }
-
-    if (prev_disk.sectors > 0) {
-        long long sec_diff = cur_disk.sectors - prev_disk.sectors;
-        disk_kb = sec_diff * 512.0 / 1024.0;
+    else {
+        proc_model_emit_resize(proc_model, old_n);
     }
-
-    prev_cpu = cur_cpu;
-    prev_disk = cur_disk;
-
-    double mem_p = get_mem_percent();
-
-    char buf[128];
-    snprintf(buf, sizeof(buf),
-        "System Total | CPU: %.1f%% | MEM: %.1f%% | Disk: %.1f KB/s",
-        cpu_p, mem_p, disk_kb);
-
-    gtk_label_set_text(GTK_LABEL(sys_label), buf);
-
-    return TRUE;
+    if (process_tree_view)
+        gtk_widget_queue_draw(process_tree_view);
 }
 
-gboolean update_system_total(gpointer user_data)
+// 选中状态按位置记录，数据更新后按 PID 找回原来的行，找不到就取消选中
+void process_view_reselect()
 {
-    CpuTotal cur_cpu = get_cpu_total();
-    DiskTotal cur_disk = get_disk_total();
-    static CpuTotal prev_cpu = { 0 };
-    static DiskTotal prev_disk = { 0 };
-
-    if (prev_cpu.total > 0) {
-        long long total_diff = cur_cpu.total - prev_cpu.total;
-        long long idle_diff = cur_cpu.idle - prev_cpu.idle;
-        if (total_diff > 0)
-            cpu_p = 100.0 * (1.0 - (double)idle_diff / total_diff);
-    }
+    if (!process_tree_view) return;
+    GtkTreeSelection* sel = gtk_tree_view_get_selection(GTK_TREE_VIEW(process_tree_view));
 
-    if (prev_disk.sectors > 0) {
-        long long sec_diff = cur_disk.sectors - prev_disk.sectors;
-        disk_kb = sec_diff * 512.0 / 1024.0;
+    int pos = (is_selection && selected_pid != -1) ? proc_model_find_pid(proc_model, selected_pid) : -1;
+    if (pos < 0) {
+        gtk_tree_selection_unselect_all(sel);
+        return;
     }
 
-    prev_cpu = cur_cpu;
-    prev_disk = cur_disk;
-    mem_p = get_mem_percent();
-    
-
-    /* 更新历史数据 */
-    perf_data.cpu[perf_data.index] = cpu_p;
-    perf_data.mem[perf_data.index] = mem_p;
-    perf_data.disk[perf_data.index] = disk_kb;
-    perf_data.index = (perf_data.index + 1) % HISTORY_LEN;
-
-    /* 更新性能面板标签 */
-    char buf[64];
-
-    //snprintf(buf, sizeof(buf), "CPU %.1f%% %.2f GHz", cpu_p, 1.4);
-    //gtk_label_set_text(GTK_LABEL(perf_cpu_label), buf);
-
-    snprintf(buf, sizeof(buf), "内存 %.1f%% %.1f GB", mem_p, 16.5);
-    gtk_label_set_text(GTK_LABEL(perf_mem_label), buf);
-
-    snprintf(buf, sizeof(buf), "磁盘 %.1f KB/s", disk_kb);
-    gtk_label_set_text(GTK_LABEL(perf_disk_label), buf);
-
-    if (cpu_drawing_area)
-        gtk_widget_queue_draw(cpu_drawing_area);
-
-    if (mem_drawing_area)
-        gtk_widget_queue_draw(mem_drawing_area);
+    GtkTreePath* path = gtk_tree_path_new_from_indices(pos, -1);
+    gtk_tree_selection_select_path(sel, path);
+    gtk_tree_view_scroll_to_cell(GTK_TREE_VIEW(process_tree_view), path, NULL, FALSE, 0, 0);
+    gtk_tree_path_free(path);
+}
 
-    if (disk_drawing_area)
-        gtk_widget_queue_draw(disk_drawing_area);
+// 设置搜索条件并重新过滤
+void search_set_query(const char* text)
+{
+    g_strlcpy(search_text, text, sizeof(search_text));
+    search_compile(search_text);
+    process_view_refresh(proc_model_refilter(proc_model));
+    process_view_reselect();
+}
 
-    return TRUE;
+static gboolean on_search_timeout(gpointer user_data)
+{
+    search_timeout = 0;
+    search_set_query(gtk_entry_get_text(GTK_ENTRY(search_entry)));
+    return G_SOURCE_REMOVE;
 }
 
-gboolean update_cpu_detail_label(gpointer user_data)
+/* 搜索框逻辑：连续输入时只在停顿后过滤一次 */
+void on_search_changed(GtkEntry* entry, gpointer user_data) 
 {
-    CpuInfo info;
-    get_cpu_info(&info);
+    if (search_timeout) g_source_remove(search_timeout);
+    search_timeout = g_timeout_add(SEARCH_DEBOUNCE_MS, on_search_timeout, NULL);
+}
 
-    char buf[256];
-    snprintf(buf, sizeof(buf),
-        "型号: %s | 核心: %d | 线程: %d | 缓存: %d KB | 当前频率: %.2f GHz | 使用率: %.1f%%",
-        info.model, info.cores, info.threads, info.cache_kb, info.freq_ghz,
-        cpu_p);
+/* ================= 点击效果 ================= */
+// stack切换
+gboolean on_stack_row_clicked(GtkWidget* widget, GdkEventButton* event, gpointer user_data)
+{
+    gpointer* data = (gpointer*)user_data;
+    GtkWidget* stack = GTK_WIDGET(data[0]);
+    const char* name = (const char*)data[1];
 
-    gtk_label_set_text(GTK_LABEL(cpu_detail_label), buf);
+    gtk_stack_set_visible_child_name(GTK_STACK(stack), name);
     return TRUE;
 }
 
-gboolean update_memory_info(gpointer data)
+// 创建可点击行
+GtkWidget* create_clickable_row(const char* text, GtkWidget* stack, const char* stack_name)
 {
-    MemStat m;
-    if (!get_mem_stat(&m)) return TRUE;
+    GtkWidget* label = gtk_label_new(text);
+    gtk_widget_set_halign(label, GTK_ALIGN_START);
+    gtk_widget_set_margin_start(label, 5);
+    gtk_widget_set_margin_top(label, 5);
 
-    // 转 GB
-    double mem_total_gb = m.mem_total / 1024.0 / 1024.0;
-    double mem_free_gb = m.mem_free / 1024.0 / 1024.0;
-    double buffers_gb = m.buffers / 1024.0 / 1024.0;
-    double cached_gb = m.cached / 1024.0 / 1024.0;
-    double swap_total_gb = m.swap_total / 1024.0 / 1024.0;
-    double swap_free_gb = m.swap_free / 1024.0 / 1024.0;
+    GtkWidget* box = gtk_event_box_new(); // EventBox 让 Label 可点击
+    gtk_container_add(GTK_CONTAINER(box), label);
 
-    double mem_used_gb = mem_total_gb - mem_free_gb - buffers_gb - cached_gb;
-    double mem_available_gb = mem_free_gb + buffers_gb + cached_gb;
-    double swap_used_gb = swap_total_gb - swap_free_gb;
+    // 用数组传递 stack 和 name
+    gpointer* data = g_new(gpointer, 2);
+    data[0] = stack;
+    data[1] = (gpointer)stack_name;
 
-    double mem_used_percent = (mem_used_gb / mem_total_gb) * 100.0;
-    double swap_used_percent = (swap_total_gb > 0) ? (swap_used_gb / swap_total_gb * 100.0) : 0.0;
+    g_signal_connect(box, "button-press-event",
+        G_CALLBACK(on_stack_row_clicked),
+        data);
 
-    char buf[512];
-    snprintf(buf, sizeof(buf),
-        "内存总量:  %.2f GB\n"
-        "已用内存:  %.2f GB (%.1f%%)\n"
-        "可用内存:  %.2f GB\n"
-        "缓冲区+缓存: %.2f GB\n"
-        "交换总量:  %.2f GB\n"
-        "已用交换:  %.2f GB (%.1f%%)",
-        mem_total_gb,
-        mem_used_gb, mem_used_percent,
-        mem_available_gb,
-        buffers_gb + cached_gb,
-        swap_total_gb,
-        swap_used_gb, swap_used_percent
-    );
+    return box;
+}
 
-    // 安全检查，确保 mem_info_label 是 GtkLabel
-    if (GTK_IS_LABEL(mem_info_label))
-        gtk_label_set_text(GTK_LABEL(mem_info_label), buf);
+void on_kill_task_clicked(GtkButton* button, gpointer user_data) 
+{ 
+    if (selected_pid <= 0) 
+    { 
+        GtkWidget* dlg = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_WARNING, GTK_BUTTONS_OK, "请先选择一个进程");
+        gtk_dialog_run(GTK_DIALOG(dlg));
+        gtk_widget_destroy(dlg); return; } 
+    if (kill(selected_pid, SIGTERM) == 0) 
+    {
+        g_print("已向 PID %d 发送 SIGTERM\n", selected_pid); 
+    } 
+    else 
+    { 
+        GtkWidget* dlg = gtk_message_dialog_new(NULL, GTK_DIALOG_MODAL, GTK_MESSAGE_ERROR, GTK_BUTTONS_OK, "无法结束该进程（权限不足或受保护进程）");
+        gtk_dialog_run(GTK_DIALOG(dlg)); gtk_widget_destroy(dlg);
+    } 
+}
+
+void column_clicked(GtkTreeViewColumn* col, gpointer user_data) 
+{
+    int col_index = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(col), "col_index"));
+    current_sort_col = col_index;
+
+    is_selection = 0; // 禁止刷新保持选中
+    selected_pid = -1;
+
+    for (int i = 0; i < NUM_COLS; i++) 
+    {
+        GdkRGBA color;
+        if (i == col_index)
+            gdk_rgba_parse(&color, "#e0e0e0"); // 选中列
+        else
+            gdk_rgba_parse(&color, "white");
+        g_object_set(renderers[i], "cell-background-rgba", &color, NULL);
+    }
+}
+
+// 由可见列决定采集线程要额外读取哪些文件
+void update_proc_need_mask()
+{
+    int need = 0;
+    if (gtk_tree_view_column_get_visible(columns[COL_DISK]))
+        need |= PROC_NEED_IO;
+    g_atomic_int_set(&proc_need_mask, need);
+}
+
+void on_column_toggled(GtkCheckMenuItem* item, gpointer user_data)
+{
+    gtk_tree_view_column_set_visible(GTK_TREE_VIEW_COLUMN(user_data), gtk_check_menu_item_get_active(item));
+    update_proc_need_mask();
+}
 
+// 列标题右键弹出列显示菜单
+gboolean on_column_header_pressed(GtkWidget* widget, GdkEventButton* event, gpointer user_data)
+{
+    if (event->type != GDK_BUTTON_PRESS || event->button != GDK_BUTTON_SECONDARY)
+        return FALSE;
+    gtk_menu_popup_at_pointer(GTK_MENU(column_menu), (GdkEvent*)event);
     return TRUE;
 }
 
+// 只有可见的图需要重画，隐藏的图下次显示时按 pushed 的差距补画
+void perf_queue_draw(GtkWidget* area)
+{
+    if (area && gtk_widget_get_mapped(area))
+        gtk_widget_queue_draw(area);
+}
 
-gboolean update_disk_info(gpointer user_data)
+void on_zoom_changed(GtkComboBox* combo, gpointer user_data)
 {
-    FILE* fp = fopen("/proc/diskstats", "r");
-    if (!fp) return TRUE;
+    int i = gtk_combo_box_get_active(combo);
+    if (i < 0) return;
+    perf_zoom = i;
+
+    perf_queue_draw(cpu_drawing_area);
+    perf_queue_draw(mem_drawing_area);
+    perf_queue_draw(disk_drawing_area);
+    for (int i = 0; i < PSI_RES; i++)
+        perf_queue_draw(psi_drawing_area[i]);
+    perf_queue_draw(net_drawing_area);
+}
 
-    char line[256];
-    DiskStats curr = { 0 };
+void on_perf_row_selected(GtkListBox* box, GtkListBoxRow* row, gpointer data)//性能面板不同类型选中逻辑
+{
+    if (!row) return;
 
-    while (fgets(line, sizeof(line), fp)) 
-    {
-        unsigned int major, minor;
-        char name[32];
-        unsigned long long read_sectors, write_sectors, busy_time;
-
-        sscanf(line, "%u %u %s %*u %*u %llu %*u %*u %*u %llu %*u %*u %llu",
-            &major, &minor, name,
-            &read_sectors, &write_sectors, &busy_time);
-
-        if (strcmp(name, "sda") == 0) { // sda 或你的磁盘
-            curr.read_sectors = read_sectors;
-            curr.write_sectors = write_sectors;
-            curr.busy_time = busy_time;
-            break;
+    int type = GPOINTER_TO_INT(
+        g_object_get_data(G_OBJECT(row), "perf_type"));
+
+    switch (type) {
+    case PERF_CPU:
+        current_perf = PERF_CPU;
+        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "cpu");
+        break;
+    case PERF_MEM:
+        current_perf = PERF_MEM;
+        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "mem");
+        break;
+    case PERF_DISK:
+        current_perf = PERF_DISK;
+        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "disk");
+        break;
+    case PERF_PSI_CPU:
+        current_perf = PERF_PSI_CPU;
+        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "psi");
+        break;
+    case PERF_NET:
+        current_perf = PERF_NET;
+        gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "net");
+        break;
+    }
+}
+
+
+/* ================= /proc 解析 ================= */
+// 手写的解析器，直接在读入的缓冲区上前进，不分配内存，替代 sscanf/fscanf
+
+static inline const char* skip_spaces(const char* p)
+{
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+}
+
+// 解析一个十进制整数并前进到其后，不是数字时跳过整个字段并返回 0
+static inline long long tok_num(const char** pp)
+{
+    const char* p = skip_spaces(*pp);
+    int neg = 0;
+    long long v = 0;
+
+    if (*p == '-') { neg = 1; p++; }
+    if (*p < '0' || *p > '9') {
+        while (*p && *p != ' ' && *p != '\t' && *p != '\n') p++;
+        *pp = p;
+        return 0;
+    }
+    while (*p >= '0' && *p <= '9')
+        v = v * 10 + (*p++ - '0');
+    *pp = p;
+    return neg ? -v : v;
+}
+
+// 取一个空白分隔的字段，返回长度，*word 指向字段开头
+static inline int tok_word(const char** pp, const char** word)
+{
+    const char* p = skip_spaces(*pp);
+    *word = p;
+    while (*p && *p != ' ' && *p != '\t' && *p != '\n') p++;
+    *pp = p;
+    return (int)(p - *word);
+}
+
+// 把一行中空格分隔的字段依次解析为整数，遇到行尾停止，返回字段数
+int parse_num_fields(const char* p, long long* out, int max)
+{
+    int n = 0;
+    while (n < max) {
+        p = skip_spaces(p);
+        if (*p == '\0' || *p == '\n') break;
+        out[n++] = tok_num(&p);
+    }
+    return n;
+}
+
+static inline const char* next_line(const char* p)
+{
+    p = strchr(p, '\n');
+    return p ? p + 1 : NULL;
+}
+
+// "Key: value kB" 格式文件的字段表，按 key 的哈希开放寻址查找
+typedef struct {
+    const char* key;
+    size_t offset;              // 目标结构体中 long long 字段的偏移
+} KvField;
+
+#define KV_SLOTS 64
+
+typedef struct {
+    const KvField* fields;
+    int nfields;
+    gsize ready;
+    guint32 hash[KV_SLOTS];
+    signed char slot[KV_SLOTS]; // 字段下标，-1 为空
+} KvTable;
+
+static inline guint32 kv_hash(const char* s, int len)
+{
+    guint32 h = 2166136261u;    // FNV-1a
+    for (int i = 0; i < len; i++)
+        h = (h ^ (guchar)s[i]) * 16777619u;
+    return h;
+}
+
+static void kv_table_build(KvTable* t)
+{
+    if (!g_once_init_enter(&t->ready)) return;
+
+    memset(t->slot, -1, sizeof(t->slot));
+    for (int i = 0; i < t->nfields; i++) {
+        guint32 h = kv_hash(t->fields[i].key, strlen(t->fields[i].key));
+        int s = h & (KV_SLOTS - 1);
+        while (t->slot[s] >= 0) s = (s + 1) & (KV_SLOTS - 1);
+        t->hash[s] = h;
+        t->slot[s] = i;
+    }
+    g_once_init_leave(&t->ready, 1);
+}
+
+static inline const KvField* kv_lookup(const KvTable* t, const char* key, int len)
+{
+    guint32 h = kv_hash(key, len);
+    for (int s = h & (KV_SLOTS - 1); t->slot[s] >= 0; s = (s + 1) & (KV_SLOTS - 1)) {
+        const KvField* f = &t->fields[t->slot[s]];
+        if (t->hash[s] == h && strncmp(f->key, key, len) == 0 && f->key[len] == '\0')
+            return f;
+    }
+    return NULL;
+}
+
+// 解析整个 "Key: value" 文件，表中存在的 key 写入 out 对应字段，返回命中数
+int parse_kv(const char* buf, KvTable* t, void* out)
+{
+    int hits = 0;
+    kv_table_build(t);
+
+    for (const char* p = buf; p && *p; p = next_line(p)) {
+        const char* colon = p;
+        while (*colon && *colon != ':' && *colon != '\n') colon++;
+        if (*colon != ':') continue;
+
+        const KvField* f = kv_lookup(t, p, (int)(colon - p));
+        if (!f) continue;
+
+        const char* v = colon + 1;
+        *(long long*)((char*)out + f->offset) = tok_num(&v);
+        hits++;
+    }
+    return hits;
+}
+
+// cgroup 的 "key value" 格式（cpu.stat、memory.stat），字段表与 parse_kv 通用
+int parse_flat_kv(const char* buf, KvTable* t, void* out)
+{
+    int hits = 0;
+    kv_table_build(t);
+
+    for (const char* p = buf; p && *p; p = next_line(p)) {
+        const char* key;
+        int len = tok_word(&p, &key);
+        const KvField* f = len > 0 ? kv_lookup(t, key, len) : NULL;
+        if (!f) continue;
+
+        *(long long*)((char*)out + f->offset) = tok_num(&p);
+        hits++;
+    }
+    return hits;
+}
+
+// 所有 /proc、/sys 路径都从根目录拼出来，--proc-root/--sys-root 可以指向容器或合成的目录
+static char proc_root[256] = "/proc";
+static char sys_root[256] = "/sys";
+
+const char* proc_path(char* buf, size_t size, const char* name)
+{
+    snprintf(buf, size, "%s/%s", proc_root, name);
+    return buf;
+}
+
+const char* sys_path(char* buf, size_t size, const char* name)
+{
+    snprintf(buf, size, "%s/%s", sys_root, name);
+    return buf;
+}
+
+// 读整个文件到 buf，返回字节数，失败返回 -1
+ssize_t read_file(const char* path, char* buf, size_t size)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+
+    size_t len = 0;
+    while (len < size - 1) {
+        ssize_t n = read(fd, buf + len, size - 1 - len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        len += n;
+    }
+    close(fd);
+    buf[len] = '\0';
+    return len;
+}
+
+// 每轮都要读的系统文件保持打开，用 pread 从头重读；读失败时重新打开一次
+typedef struct {
+    const char* name;           // 相对 proc_root 的路径
+    int fd;                     // 未打开为 -1
+} PinnedFile;
+
+ssize_t pinned_file_read(PinnedFile* f, char* buf, size_t size)
+{
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (f->fd < 0) {
+            char path[300];
+            f->fd = open(proc_path(path, sizeof(path), f->name), O_RDONLY | O_CLOEXEC);
+            if (f->fd < 0) return -1;
+        }
+
+        size_t len = 0;
+        ssize_t n = 0;
+        while (len < size - 1) {
+            n = pread(f->fd, buf + len, size - 1 - len, len);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            len += n;
         }
+        if (n >= 0) {
+            buf[len] = '\0';
+            return len;
+        }
+        close(f->fd);
+        f->fd = -1;
     }
-    fclose(fp);
+    return -1;
+}
 
-    double delta_read = (curr.read_sectors - last_disk_stats.read_sectors) * 512.0 / 1024.0;
-    double delta_write = (curr.write_sectors - last_disk_stats.write_sectors) * 512.0 / 1024.0;
-    double delta_busy = (curr.busy_time - last_disk_stats.busy_time) / 10.0; // 百分比
+// /proc/diskstats 一行：major minor name 后面依次是各计数
+typedef struct {
+    char name[DISK_NAME_MAX];
+    long long v[11];            // 读次数、合并、扇区、毫秒，写同样四项，然后是在途请求数、io_ticks(ms)
+    int nv;
+} DiskLine;
 
-    last_disk_stats = curr;
+int parse_diskstats_line(const char* p, DiskLine* d)
+{
+    const char* name;
+    tok_num(&p);
+    tok_num(&p);
+    int len = tok_word(&p, &name);
+    if (len <= 0) return 0;
+    if (len >= (int)sizeof(d->name)) len = sizeof(d->name) - 1;
+    memcpy(d->name, name, len);
+    d->name[len] = '\0';
+
+    d->nv = parse_num_fields(p, d->v, 11);
+    return d->nv >= 10;
+}
 
-    char buf[128];
-    snprintf(buf, sizeof(buf), "读取速度: %.1f KB/s", delta_read);
-    gtk_label_set_text(GTK_LABEL(disk_read_label), buf);
+/* ================= 系统 CPU ================= */
+// /proc/stat 的 "cpu" 汇总行
+CpuTotal parse_cpu_total(const char* buf)
+{
+    CpuTotal c = { 0 };
+    if (strncmp(buf, "cpu ", 4) != 0) return c;
 
-    snprintf(buf, sizeof(buf), "写入速度: %.1f KB/s", delta_write);
-    gtk_label_set_text(GTK_LABEL(disk_write_label), buf);
+    int n = parse_num_fields(buf + 4, c.f, CPU_FIELDS);
+    if (n >= 7) {
+        c.idle = c.f[CPU_IDLE] + c.f[CPU_IOWAIT];
+        for (int i = 0; i < CPU_FIELDS; i++)
+            c.total += c.f[i];
+    }
+    return c;
+}
 
-    snprintf(buf, sizeof(buf), "活动时间: %.1f %%", delta_busy);
-    gtk_label_set_text(GTK_LABEL(disk_active_label), buf);
+static void core_counters_reserve(CoreCounters* c, int n)
+{
+    if (n <= c->cap) return;
+    int cap = MAX(n, c->cap * 2);
+    for (int i = 0; i < CPU_FIELDS; i++) {
+        c->f[i] = g_renew(long long, c->f[i], cap);
+        memset(c->f[i] + c->cap, 0, (cap - c->cap) * sizeof(long long));
+    }
+    c->cap = cap;
+}
 
-    if (disk_drawing_area) gtk_widget_queue_draw(disk_drawing_area);
+static void core_counters_zero(CoreCounters* c, int from, int to)
+{
+    if (from >= to) return;
+    for (int i = 0; i < CPU_FIELDS; i++)
+        memset(c->f[i] + from, 0, (to - from) * sizeof(long long));
+}
 
-    return TRUE;
+// 解析汇总的 cpu 行和后面所有 cpuN 行。数组在两轮之间复用，
+// 离线的核没有对应行，跳过的编号和末尾都要清零，否则会留着上上轮的计数
+void parse_cpu_stat(const char* buf, CpuTotal* total, CoreCounters* cores)
+{
+    *total = parse_cpu_total(buf);
+    cores->n = 0;
+
+    for (const char* p = next_line(buf); p && strncmp(p, "cpu", 3) == 0; p = next_line(p)) {
+        const char* q = p + 3;
+        if (!isdigit((unsigned char)*q)) break;
+        long long id = tok_num(&q);
+        if (id < cores->n) continue;    // 编号按升序排列，乱序的行不可信
+
+        long long v[CPU_FIELDS] = { 0 };
+        parse_num_fields(q, v, CPU_FIELDS);
+
+        core_counters_reserve(cores, (int)id + 1);
+        core_counters_zero(cores, cores->n, (int)id);
+        for (int i = 0; i < CPU_FIELDS; i++)
+            cores->f[i][id] = v[i];
+        cores->n = (int)id + 1;
+    }
+    core_counters_zero(cores, cores->n, cores->cap);
 }
 
+int get_cpu_stat(CpuTotal* total, CoreCounters* cores)
+{
+    char buf[65536];    // 128 核以上时 /proc/stat 的 cpuN 行也能放下
+    char path[300];
+    memset(total, 0, sizeof(CpuTotal));
+    cores->n = 0;
+    if (read_file(proc_path(path, sizeof(path), "stat"), buf, sizeof(buf)) <= 0) return 0;
+    parse_cpu_stat(buf, total, cores);
+    return 1;
+}
 
-//标签创建
-GtkWidget* create_cpu_info_label(GtkWidget* parent)
+// 每核占用 = 1 - (Δidle + Δiowait) / Δtotal。逐字段在连续数组上累加，内层循环没有分支
+void core_usage_delta(const CoreCounters* cur, const CoreCounters* prev, float* usage, long long* busy, long long* total)
 {
-    cpu_detail_label = gtk_label_new("正在获取 CPU 信息...");
-    gtk_widget_set_halign(cpu_detail_label, GTK_ALIGN_START);
-    gtk_widget_set_valign(cpu_detail_label, GTK_ALIGN_START);
+    int n = MIN(cur->n, prev->n);
 
-    g_timeout_add_seconds(flash_time, update_cpu_detail_label, NULL);
+    for (int i = 0; i < n; i++) {
+        busy[i] = 0;
+        total[i] = 0;
+    }
+    for (int f = 0; f < CPU_FIELDS; f++) {
+        const long long* restrict a = cur->f[f];
+        const long long* restrict b = prev->f[f];
+        if (f == CPU_IDLE || f == CPU_IOWAIT) {
+            for (int i = 0; i < n; i++)
+                total[i] += a[i] - b[i];
+        }
+        else {
+            for (int i = 0; i < n; i++) {
+                long long d = a[i] - b[i];
+                total[i] += d;
+                busy[i] += d;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++)
+        usage[i] = total[i] > 0 ? 100.0f * (float)busy[i] / (float)total[i] : 0.0f;
+    for (int i = n; i < cur->n; i++)
+        usage[i] = 0.0f;
+}
 
-    return cpu_detail_label;
+// 每核占用数组随快照交给界面线程，快照释放时放回这里，采集线程下一轮直接复用。
+// 池里的数组容量都是 core_usage_cap，核数变多时旧数组作废
+#define CORE_USAGE_POOL 4
+static GMutex core_usage_lock;
+static float* core_usage_pool[CORE_USAGE_POOL];
+static int n_core_usage_pool = 0;
+static int core_usage_cap = 0;
+
+static float* core_usage_take(int cap, int* got_cap)
+{
+    float* buf = NULL;
+    g_mutex_lock(&core_usage_lock);
+    if (cap > core_usage_cap) {
+        for (int i = 0; i < n_core_usage_pool; i++)
+            g_free(core_usage_pool[i]);
+        n_core_usage_pool = 0;
+        core_usage_cap = cap;
+    }
+    if (n_core_usage_pool > 0)
+        buf = core_usage_pool[--n_core_usage_pool];
+    *got_cap = core_usage_cap;
+    g_mutex_unlock(&core_usage_lock);
+    return buf ? buf : g_new(float, *got_cap);
 }
 
-//进程面板
-GtkWidget* create_process_panel()
+static void core_usage_give(float* buf, int cap)
 {
+    if (!buf) return;
+    g_mutex_lock(&core_usage_lock);
+    if (cap == core_usage_cap && n_core_usage_pool < CORE_USAGE_POOL) {
+        core_usage_pool[n_core_usage_pool++] = buf;
+        buf = NULL;
+    }
+    g_mutex_unlock(&core_usage_lock);
+    g_free(buf);
+}
 
-    process_panel_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+void get_cpu_info(CpuInfo* info)
+{
+    char path[300];
+    FILE* fp = fopen(proc_path(path, sizeof(path), "cpuinfo"), "r");
+    if (!fp) {
+        strcpy(info->model, "unknown");
+        info->cores = 0;
+        info->threads = 0;
+        info->cache_kb = 0;
+        info->freq_ghz = 0.0;
+        return;
+    }
 
-    // 系统状态标签
-    GtkWidget* sys_label = gtk_label_new("System Total | CPU: 0% | MEM: 0% | Disk: 0 KB/s");
-    gtk_box_pack_start(GTK_BOX(process_panel_box), sys_label, FALSE, FALSE, 5);
+    char line[256];
+    info->cores = 0;
+    info->threads = 0;
+    info->cache_kb = 0;
+    info->model[0] = '\0';
 
-    // 创建 ListStore
-    store = gtk_list_store_new(NUM_COLS,
-        G_TYPE_INT,
-        G_TYPE_STRING,
-        G_TYPE_DOUBLE,
-        G_TYPE_DOUBLE,
-        G_TYPE_DOUBLE);
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, "model name", 10) == 0 && info->model[0] == '\0') {
+            char* p = strchr(line, ':');
+            if (p) {
+                p += 2;
+                strncpy(info->model, p, sizeof(info->model) - 1);
+                info->model[strcspn(info->model, "\n")] = 0;
+            }
+        }
+        else if (strncmp(line, "cpu cores", 9) == 0 && info->cores == 0) {
+            int cores = 0;
+            sscanf(line, "cpu cores\t: %d", &cores);
+            info->cores = cores;
+        }
+        else if (strncmp(line, "processor", 9) == 0) {
+            info->threads++;
+        }
+        else if (strncmp(line, "cache size", 10) == 0 && info->cache_kb == 0) {
+            int cache = 0;
+            sscanf(line, "cache size\t: %d", &cache);
+            info->cache_kb = cache;
+        }
+    }
+    fclose(fp);
 
-    // 模糊搜索模型
-    filter_model = GTK_TREE_MODEL_FILTER(gtk_tree_model_filter_new(GTK_TREE_MODEL(store), NULL));
-    gtk_tree_model_filter_set_visible_func(filter_model, filter_visible_func, NULL, NULL);
+    // ----- 频率读取 fallback -----
 
-    // 排序模型
-    sort_model = GTK_TREE_MODEL_SORT(gtk_tree_model_sort_new_with_model(GTK_TREE_MODEL(filter_model)));
-    process_tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(sort_model));
+    long freq = 0;
+
+    // ① scaling_cur_freq
+    fp = fopen(sys_path(path, sizeof(path), "devices/system/cpu/cpu0/cpufreq/scaling_cur_freq"), "r");
+    if (fp) {
+        fscanf(fp, "%ld", &freq);
+        fclose(fp);
+        info->freq_ghz = freq / 1000000.0;
+        return;
+    }
+
+    // ② cpuinfo_cur_freq
+    fp = fopen(sys_path(path, sizeof(path), "devices/system/cpu/cpu0/cpufreq/cpuinfo_cur_freq"), "r");
+    if (fp) {
+        fscanf(fp, "%ld", &freq);
+        fclose(fp);
+        info->freq_ghz = freq / 1000000.0;
+        return;
+    }
+
+    // ③ /proc/cpuinfo 的 cpu MHz
+    fp = fopen(proc_path(path, sizeof(path), "cpuinfo"), "r");
+    if (fp) {
+        while (fgets(line, sizeof(line), fp)) {
+            if (sscanf(line, "cpu MHz\t: %ld", &freq) == 1) {
+                info->freq_ghz = freq / 1000.0;
+                fclose(fp);
+                return;
+            }
+        }
+        fclose(fp);
+    }
+
+    // fallback
+    info->freq_ghz = 0.0;
+}
+
+
+/* ================= 系统内存 ================= */
+static const KvField meminfo_fields[] = {
+    { "MemTotal",     offsetof(MemStat, mem_total) },
+    { "MemFree",      offsetof(MemStat, mem_free) },
+    { "MemAvailable", offsetof(MemStat, mem_available) },
+    { "Buffers",      offsetof(MemStat, buffers) },
+    { "Cached",       offsetof(MemStat, cached) },
+    { "SwapTotal",    offsetof(MemStat, swap_total) },
+    { "SwapFree",     offsetof(MemStat, swap_free) },
+    { "Active",       offsetof(MemStat, active) },
+    { "Inactive",     offsetof(MemStat, inactive) },
+    { "Slab",         offsetof(MemStat, slab) },
+    { "Shmem",        offsetof(MemStat, shmem) },
+    { "SReclaimable", offsetof(MemStat, sreclaimable) },
+    { "SUnreclaim",   offsetof(MemStat, sunreclaim) },
+};
+static KvTable meminfo_table = { meminfo_fields, G_N_ELEMENTS(meminfo_fields) };
+
+void parse_meminfo(const char* buf, MemStat* m)
+{
+    memset(m, 0, sizeof(MemStat));
+    parse_kv(buf, &meminfo_table, m);
+}
+
+int get_mem_stat(MemStat* m)
+{
+    char buf[8192];
+    char path[300];
+    if (read_file(proc_path(path, sizeof(path), "meminfo"), buf, sizeof(buf)) <= 0) return 0;
+    parse_meminfo(buf, m);
+    return 1;
+}
+
+double get_mem_percent(const MemStat* m) 
+{
+    return m->mem_total ? 100.0 * (m->mem_total - m->mem_available) / m->mem_total : 0.0;
+}
+
+/* ================= 系统磁盘 ================= */
+// 整盘设备从 /sys/block 发现：那里没有分区，loop、ram、zram 设备跳过，数量不设上限。
+// 每轮只读 /proc/diskstats，设备名集合变化（热插拔）时才重新扫描 /sys/block
+typedef struct {
+    char name[DISK_NAME_MAX];
+    int stacked;
+} DiskDev;
+
+static PinnedFile diskstats_file = { "diskstats", -1 };
+static DiskDev* disk_devs = NULL;
+static int n_disk_devs = 0;
+static int disk_devs_cap = 0;
+static guint32 disk_sig = 0;    // diskstats 中设备名的哈希，为 0 时下一轮重新扫描
+
+// slaves 目录非空说明是 dm、md 之类叠加在其他磁盘上的设备
+static int disk_dev_stacked(const char* name)
+{
+    char rel[300];
+    char path[300];
+    snprintf(rel, sizeof(rel), "block/%s/slaves", name);
+    DIR* dir = opendir(sys_path(path, sizeof(path), rel));
+    if (!dir) return 0;
+
+    int stacked = 0;
+    struct dirent* d;
+    while (!stacked && (d = readdir(dir)))
+        stacked = d->d_name[0] != '.';
+    closedir(dir);
+    return stacked;
+}
+
+static int compare_disk_dev(const void* a, const void* b)
+{
+    return strcmp(((const DiskDev*)a)->name, ((const DiskDev*)b)->name);
+}
+
+void disk_scan_devices()
+{
+    char path[300];
+    n_disk_devs = 0;
+    DIR* dir = opendir(sys_path(path, sizeof(path), "block"));
+    if (!dir) return;
+
+    struct dirent* d;
+    while ((d = readdir(dir))) {
+        const char* name = d->d_name;
+        if (name[0] == '.' || strncmp(name, "loop", 4) == 0 || strncmp(name, "ram", 3) == 0) continue;
+        // zram 是内存里的压缩交换区，读写不落盘
+        if (strncmp(name, "zram", 4) == 0) continue;
+        if (strlen(name) >= DISK_NAME_MAX) continue;
+
+        if (n_disk_devs == disk_devs_cap) {
+            disk_devs_cap = MAX(16, disk_devs_cap * 2);
+            disk_devs = g_renew(DiskDev, disk_devs, disk_devs_cap);
+        }
+        DiskDev* dev = &disk_devs[n_disk_devs++];
+        strcpy(dev->name, name);
+        dev->stacked = disk_dev_stacked(name);
+    }
+    closedir(dir);
+    qsort(disk_devs, n_disk_devs, sizeof(DiskDev), compare_disk_dev);
+}
+
+static int disk_dev_index(const char* name)
+{
+    for (int i = 0; i < n_disk_devs; i++)
+        if (strcmp(disk_devs[i].name, name) == 0) return i;
+    return -1;
+}
+
+// 一次读 /proc/diskstats，*out 与 disk_devs 一一对应，容量不够时增长到 *cap，
+// 返回设备数，读取失败返回 -1
+int get_disk_stats(DiskCounters** out, int* cap)
+{
+    char buf[32768];
+    if (pinned_file_read(&diskstats_file, buf, sizeof(buf)) <= 0) return -1;
+
+    // 第一遍发现设备集合变了就重新扫描再来一遍
+    for (int pass = 0; pass < 2; pass++) {
+        guint32 sig = 2166136261u;
+        if (n_disk_devs > *cap) {
+            *cap = disk_devs_cap;
+            *out = g_renew(DiskCounters, *out, *cap);
+        }
+        memset(*out, 0, sizeof(DiskCounters) * n_disk_devs);
+        for (int i = 0; i < n_disk_devs; i++) {
+            strcpy((*out)[i].name, disk_devs[i].name);
+            (*out)[i].stacked = disk_devs[i].stacked;
+        }
+
+        DiskLine dl;
+        for (const char* p = buf; p && *p; p = next_line(p)) {
+            if (!parse_diskstats_line(p, &dl))
+                continue;
+            sig = (sig ^ kv_hash(dl.name, strlen(dl.name))) * 16777619u;
+
+            int i = disk_dev_index(dl.name);
+            if (i < 0) continue;
+            DiskCounters* c = &(*out)[i];
+            c->rd_ios = dl.v[0];
+            c->rd_sectors = dl.v[2];
+            c->rd_ms = dl.v[3];
+            c->wr_ios = dl.v[4];
+            c->wr_sectors = dl.v[6];
+            c->wr_ms = dl.v[7];
+            c->in_flight = dl.v[8];
+            c->io_ticks = dl.v[9];
+        }
+        if (sig == disk_sig) break;
+        disk_scan_devices();
+        disk_sig = sig;
+    }
+    return n_disk_devs;
+}
+
+/* ================= 压力信息 ================= */
+// "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456"，full 行格式相同；
+// 老内核的 cpu 文件没有 full 行，相应字段保持 0
+int parse_psi(const char* buf, PsiStat* ps)
+{
+    memset(ps, 0, sizeof(PsiStat));
+    for (const char* p = buf; p && *p; p = next_line(p)) {
+        const char* word;
+        int len = tok_word(&p, &word);
+        PsiLine* l;
+        if (len == 4 && strncmp(word, "some", 4) == 0) l = &ps->some;
+        else if (len == 4 && strncmp(word, "full", 4) == 0) l = &ps->full;
+        else continue;
+
+        while ((len = tok_word(&p, &word)) > 0) {
+            const char* eq = memchr(word, '=', len);
+            if (!eq) continue;
+            int klen = (int)(eq - word);
+            const char* v = eq + 1;
+            if (klen == 5 && strncmp(word, "total", 5) == 0)
+                l->total = tok_num(&v);
+            else if (klen == 5 && strncmp(word, "avg10", 5) == 0)
+                l->avg10 = g_ascii_strtod(v, NULL);
+            else if (klen == 5 && strncmp(word, "avg60", 5) == 0)
+                l->avg60 = g_ascii_strtod(v, NULL);
+            else if (klen == 6 && strncmp(word, "avg300", 6) == 0)
+                l->avg300 = g_ascii_strtod(v, NULL);
+        }
+        ps->ok = 1;
+    }
+    return ps->ok;
+}
+
+int get_psi(const char* path, PsiStat* ps)
+{
+    char buf[512];
+    memset(ps, 0, sizeof(PsiStat));
+    if (read_file(path, buf, sizeof(buf)) <= 0) return 0;
+    return parse_psi(buf, ps);
+}
+
+static const char* psi_proc_names[PSI_RES] = { "pressure/cpu", "pressure/memory", "pressure/io" };
+static const char* psi_cgroup_names[PSI_RES] = { "cpu.pressure", "memory.pressure", "io.pressure" };
+
+// 格式化一种资源的 some/full 三个平均值
+static void format_psi(char* buf, size_t size, const char* title, const PsiStat* ps)
+{
+    snprintf(buf, size, "%s  some %.2f / %.2f / %.2f %%  full %.2f / %.2f / %.2f %%",
+        title, ps->some.avg10, ps->some.avg60, ps->some.avg300,
+        ps->full.avg10, ps->full.avg60, ps->full.avg300);
+}
+
+/* ================= 网络 ================= */
+// 两个文件每轮都读，fd 一直保持打开
+static PinnedFile net_dev_file = { "net/dev", -1 };
+static PinnedFile net_snmp_file = { "net/snmp", -1 };
+
+// "  eth0: rx 8 个字段 | tx 8 个字段"，前两行是表头；超过 max 个接口的部分忽略
+int parse_net_dev(const char* buf, NetDevCounters* out, int max)
+{
+    int n = 0;
+    const char* p = next_line(buf);
+    if (p) p = next_line(p);
+
+    for (; p && *p && n < max; p = next_line(p)) {
+        const char* colon = p;
+        while (*colon && *colon != ':' && *colon != '\n') colon++;
+        if (*colon != ':') continue;
+
+        const char* name = skip_spaces(p);
+        int len = (int)(colon - name);
+        if (len <= 0) continue;
+        if (len >= NET_NAME_MAX) len = NET_NAME_MAX - 1;
+
+        long long v[16];
+        if (parse_num_fields(colon + 1, v, 16) < 16) continue;
+
+        NetDevCounters* c = &out[n++];
+        memcpy(c->name, name, len);
+        c->name[len] = '\0';
+        c->rx_bytes = v[0];
+        c->rx_packets = v[1];
+        c->rx_errs = v[2];
+        c->rx_drop = v[3];
+        c->tx_bytes = v[8];
+        c->tx_packets = v[9];
+        c->tx_errs = v[10];
+        c->tx_drop = v[11];
+    }
+    return n;
+}
+
+int get_net_dev(NetDevCounters* out, int max)
+{
+    char buf[16384];
+    if (pinned_file_read(&net_dev_file, buf, sizeof(buf)) <= 0) return 0;
+    return parse_net_dev(buf, out, max);
+}
+
+static const KvField tcp_fields[] = {
+    { "ActiveOpens",  offsetof(TcpStat, active_opens) },
+    { "PassiveOpens", offsetof(TcpStat, passive_opens) },
+    { "CurrEstab",    offsetof(TcpStat, curr_estab) },
+    { "InSegs",       offsetof(TcpStat, in_segs) },
+    { "OutSegs",      offsetof(TcpStat, out_segs) },
+    { "RetransSegs",  offsetof(TcpStat, retrans_segs) },
+    { "InErrs",       offsetof(TcpStat, in_errs) },
+};
+static KvTable tcp_table = { tcp_fields, G_N_ELEMENTS(tcp_fields) };
+
+// /proc/net/snmp 每个协议两行："Tcp: 字段名..." 和 "Tcp: 数值..."，按位置一一对应
+int parse_tcp_stat(const char* buf, TcpStat* t)
+{
+    memset(t, 0, sizeof(TcpStat));
+    kv_table_build(&tcp_table);
+
+    const char* names = buf;
+    while (names && strncmp(names, "Tcp:", 4) != 0)
+        names = next_line(names);
+    const char* values = names ? next_line(names) : NULL;
+    if (!values || strncmp(values, "Tcp:", 4) != 0) return 0;
+
+    names += 4;
+    values += 4;
+    int hits = 0;
+    for (;;) {
+        const char* key;
+        int len = tok_word(&names, &key);
+        if (len == 0) break;
+        long long v = tok_num(&values);
+        const KvField* f = kv_lookup(&tcp_table, key, len);
+        if (!f) continue;
+        *(long long*)((char*)t + f->offset) = v;
+        hits++;
+    }
+    return hits > 0;
+}
+
+int get_tcp_stat(TcpStat* t)
+{
+    char buf[8192];
+    memset(t, 0, sizeof(TcpStat));
+    if (pinned_file_read(&net_snmp_file, buf, sizeof(buf)) <= 0) return 0;
+    return parse_tcp_stat(buf, t);
+}
+
+// proc_root/sys_root 切换后调用，常驻的 fd 和设备列表都要重新建立
+void system_files_reset()
+{
+    PinnedFile* files[] = { &diskstats_file, &net_dev_file, &net_snmp_file };
+    for (int i = 0; i < (int)G_N_ELEMENTS(files); i++) {
+        if (files[i]->fd >= 0) close(files[i]->fd);
+        files[i]->fd = -1;
+    }
+    disk_sig = 0;
+}
+
+/* ================= /proc 文件描述符缓存 ================= */
+// 长期存活的进程保持 /proc/PID/stat 和 /proc/PID/io 打开，每轮用 pread 从头重读，
+// 省掉 open/close。进程退出后 pread 返回 ESRCH，PID 被复用时 starttime 不一致，
+// 两种情况都会丢弃旧条目。
+enum {
+    FD_STAT,
+    FD_IO,
+    FD_SLOTS
+};
+
+#define FD_CLOSED  (-1)
+#define FD_DENIED  (-2)   // 无权限打开，进程存活期间不再重试
+#define FD_RESERVE 256    // 给 GTK 等其他部分保留的 fd 数
+#define FD_BUDGET_MAX 65536 // 自动计算时的上限，软上限很大或不限时也不会占住过多 fd
+
+static const char* proc_fd_files[FD_SLOTS] = { "stat", "io" };
+
+typedef struct FdCacheEntry {
+    int pid;
+    unsigned long long starttime;
+    int fd[FD_SLOTS];
+    guint gen;                  // 最后一次被访问的轮次
+    struct FdCacheEntry* prev;  // LRU 链表，head 为最近使用
+    struct FdCacheEntry* next;
+} FdCacheEntry;
+
+typedef struct {
+    GHashTable* table;          // pid -> FdCacheEntry
+    FdCacheEntry* head;
+    FdCacheEntry* tail;
+    int nfds;                   // 本分片打开的 fd 数
+    guint gen;
+    long saved;                 // 本轮省下的系统调用次数
+} FdCache;
+
+static int fd_cache_limit = 0;  // --fd-budget，只能调低自动计算的结果，0 表示不限制
+
+// 所有分片共用一个预算：按分片平分时核数多的机器每片只剩一两个 fd，
+// 这里只限制总数，预算用满时各分片淘汰自己 LRU 里本轮没用到的条目
+static int fd_budget_total = 0;
+static gint fd_open_total = 0;
+
+// 计算所有 fd 缓存加起来可用的 fd 数：当前软上限的一半再扣掉保留部分。
+// 不修改进程的 RLIMIT_NOFILE，GTK 和其他库也依赖它
+int fd_cache_total_budget(int limit)
+{
+    struct rlimit rl;
+    long soft = 1024;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0)
+        soft = rl.rlim_cur >= (rlim_t)4 * FD_BUDGET_MAX ? 4L * FD_BUDGET_MAX : (long)rl.rlim_cur;  // 包括 RLIM_INFINITY
+
+    long avail = MIN(soft / 2 - FD_RESERVE, FD_BUDGET_MAX);
+    if (avail < 0) avail = 0;
+    return (limit > 0 && limit < avail) ? limit : (int)avail;
+}
+
+void fd_cache_init(FdCache* c)
+{
+    memset(c, 0, sizeof(FdCache));
+    c->table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+}
+
+static void lru_unlink(FdCache* c, FdCacheEntry* e)
+{
+    if (e->prev) e->prev->next = e->next; else c->head = e->next;
+    if (e->next) e->next->prev = e->prev; else c->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void lru_push_front(FdCache* c, FdCacheEntry* e)
+{
+    e->prev = NULL;
+    e->next = c->head;
+    if (c->head) c->head->prev = e; else c->tail = e;
+    c->head = e;
+}
+
+static void fd_cache_close_slot(FdCache* c, FdCacheEntry* e, int slot)
+{
+    if (e->fd[slot] >= 0) {
+        close(e->fd[slot]);
+        c->nfds--;
+        g_atomic_int_add(&fd_open_total, -1);
+    }
+    e->fd[slot] = FD_CLOSED;
+}
+
+void fd_cache_drop(FdCache* c, FdCacheEntry* e)
+{
+    for (int i = 0; i < FD_SLOTS; i++)
+        fd_cache_close_slot(c, e, i);
+    lru_unlink(c, e);
+    g_hash_table_remove(c->table, GINT_TO_POINTER(e->pid));
+}
+
+FdCacheEntry* fd_cache_lookup(FdCache* c, int pid)
+{
+    FdCacheEntry* e = g_hash_table_lookup(c->table, GINT_TO_POINTER(pid));
+    if (e && c->head != e) {
+        lru_unlink(c, e);
+        lru_push_front(c, e);
+    }
+    if (e) e->gen = c->gen;
+    return e;
+}
+
+// 在总预算里占一个位置，满了就淘汰本分片本轮还没用到的条目，避免全量扫描时 LRU 抖动；
+// 成功返回 1，调用方必须把 fd 记入本分片
+static int fd_cache_make_room(FdCache* c)
+{
+    for (;;) {
+        if (g_atomic_int_add(&fd_open_total, 1) < fd_budget_total) return 1;
+        g_atomic_int_add(&fd_open_total, -1);
+
+        FdCacheEntry* victim = c->tail;
+        if (!victim || victim->gen == c->gen) return 0;
+        fd_cache_drop(c, victim);
+    }
+}
+
+static FdCacheEntry* fd_cache_attach(FdCache* c, int pid)
+{
+    FdCacheEntry* e = fd_cache_lookup(c, pid);
+    if (e) return e;
+
+    e = g_new0(FdCacheEntry, 1);
+    e->pid = pid;
+    e->gen = c->gen;
+    for (int i = 0; i < FD_SLOTS; i++)
+        e->fd[i] = FD_CLOSED;
+    g_hash_table_insert(c->table, GINT_TO_POINTER(pid), e);
+    lru_push_front(c, e);
+    return e;
+}
+
+// 每轮开始时调用
+void fd_cache_begin_tick(FdCache* c)
+{
+    c->gen++;
+    c->saved = 0;
+}
+
+// 每轮结束时关闭本轮没有出现的进程（已退出）的 fd
+void fd_cache_sweep(FdCache* c)
+{
+    while (c->tail && c->tail->gen != c->gen)
+        fd_cache_drop(c, c->tail);
+}
+
+// stat 解析出 starttime 后调用，不一致说明 PID 已被复用，其余 fd 属于旧进程
+void fd_cache_check_starttime(FdCache* c, int pid, unsigned long long starttime)
+{
+    if (!c) return;
+    FdCacheEntry* e = g_hash_table_lookup(c->table, GINT_TO_POINTER(pid));
+    if (!e) return;
+
+    if (e->starttime && e->starttime != starttime) {
+        for (int i = 0; i < FD_SLOTS; i++)
+            if (i != FD_STAT) fd_cache_close_slot(c, e, i);
+    }
+    e->starttime = starttime;
+}
+
+// 读取 /proc/PID/<file> 的全部内容到 buf，返回字节数，失败返回 -1。c 为 NULL 时不缓存
+ssize_t proc_file_read(FdCache* c, int pid, int slot, char* buf, size_t size)
+{
+    FdCacheEntry* e = c ? fd_cache_lookup(c, pid) : NULL;
+    ssize_t n;
+
+    if (e && e->fd[slot] == FD_DENIED) {
+        c->saved += 1;
+        return -1;
+    }
+
+    if (e && e->fd[slot] >= 0) {
+        n = pread(e->fd[slot], buf, size - 1, 0);
+        if (n >= 0) {
+            buf[n] = '\0';
+            c->saved += 2;
+            return n;
+        }
+        // 通常是 ESRCH：旧进程已退出，路径可能已经指向复用该 PID 的新进程
+        fd_cache_drop(c, e);
+        e = NULL;
+    }
+
+    char path[300];
+    snprintf(path, sizeof(path), "%s/%d/%s", proc_root, pid, proc_fd_files[slot]);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (c && (errno == EACCES || errno == EPERM))
+            fd_cache_attach(c, pid)->fd[slot] = FD_DENIED;
+        return -1;
+    }
+
+    n = pread(fd, buf, size - 1, 0);
+    if (n < 0) {
+        close(fd);
+        return -1;
+    }
+    buf[n] = '\0';
+
+    if (c && fd_budget_total > 0 && fd_cache_make_room(c)) {
+        e = fd_cache_attach(c, pid);
+        e->fd[slot] = fd;
+        c->nfds++;
+    }
+    else {
+        close(fd);
+    }
+    return n;
+}
+
+/* ================= 进程 stat ================= */
+// 名字、状态、CPU 时间和 RSS 都从 /proc/PID/stat 一次读出。
+// nfields 为 state 之后要解析的数字字段数，37 个才能拿到 processor
+static int parse_stat_fields(const char* buf, ProcStat* ps, int nfields)
+{
+    // comm 可能包含空格和括号，以最后一个 ')' 为准
+    const char* l = strchr(buf, '(');
+    const char* r = strrchr(buf, ')');
+    if (!l || !r || r < l || r[1] != ' ') return 0;
+
+    size_t n = r - l - 1;
+    if (n >= sizeof(ps->name)) n = sizeof(ps->name) - 1;
+    memcpy(ps->name, l + 1, n);
+    ps->name[n] = '\0';
+
+    // f[k] 为第 k+3 个字段：state ppid ... utime(14) stime(15) ... starttime(22) vsize(23) rss(24)
+    // ... processor(39)
+    long long f[37];
+    ps->state = r[2];
+    if (parse_num_fields(r + 2, f, nfields) < 22) return 0;
+
+    ps->ppid = (int)f[1];
+    ps->utime = f[11];
+    ps->stime = f[12];
+    ps->starttime = (unsigned long long)f[19];
+    ps->rss_pages = f[21];
+    ps->processor = nfields >= 37 ? (int)f[36] : -1;
+    return 1;
+}
+
+int parse_proc_stat(const char* buf, ProcStat* ps)
+{
+    return parse_stat_fields(buf, ps, 22);
+}
+
+// /proc/PID/task/TID/stat 与进程 stat 格式相同，多解析到 processor
+int parse_task_stat(const char* buf, ProcStat* ps)
+{
+    return parse_stat_fields(buf, ps, 37);
+}
+
+int get_proc_stat(FdCache* fc, int pid, ProcStat* ps) 
+{
+    char buf[1024];
+    if (proc_file_read(fc, pid, FD_STAT, buf, sizeof(buf)) <= 0) return 0;
+    if (!parse_proc_stat(buf, ps)) return 0;
+
+    fd_cache_check_starttime(fc, pid, ps->starttime);
+    return 1;
+}
+
+/* ================= 进程 I/O ================= */
+static const KvField proc_io_fields[] = {
+    { "read_bytes",  offsetof(ProcIO, read_bytes) },
+    { "write_bytes", offsetof(ProcIO, write_bytes) },
+};
+static KvTable proc_io_table = { proc_io_fields, G_N_ELEMENTS(proc_io_fields) };
+
+void parse_proc_io(const char* buf, ProcIO* io)
+{
+    io->read_bytes = io->write_bytes = 0;
+    parse_kv(buf, &proc_io_table, io);
+}
+
+int get_proc_io(FdCache* fc, int pid, ProcIO* io) 
+{
+    char buf[512];
+    if (proc_file_read(fc, pid, FD_IO, buf, sizeof(buf)) < 0) return 0;
+    parse_proc_io(buf, io);
+    return 1;
+}
+
+/* ================= 进程搜索键 ================= */
+// cmdline 和用户名只在第一次看到进程、进程 exec 后名字变了或者换了 cgroup 时才读取，
+// 其余轮次直接复制缓存的搜索键。
+#define CMDLINE_MAX 1024
+
+typedef struct {
+    unsigned long long starttime;
+    char name[128];
+    char* key;
+    gsize len;                  // 不含结尾的 '\0'
+    guint gen;
+    guint cg_gen;               // 上次读 /proc/PID/cgroup 的轮次
+    guint32 cg_hash;            // 当时的 cgroup 路径，进程被移到别的组时重新生成搜索键
+} ProcKey;
+
+// 每隔这么多轮重读一次 cgroup，各进程按 PID 错开，每轮只读约 1/16 的进程
+#define CGROUP_RECHECK 16
+
+static GHashTable* user_names;  // uid -> 用户名，各扫描线程共用
+static GMutex user_lock;
+
+const char* get_user_name(uid_t uid)
+{
+    g_mutex_lock(&user_lock);
+    if (!user_names)
+        user_names = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+
+    char* name = g_hash_table_lookup(user_names, GUINT_TO_POINTER(uid));
+    if (!name) {
+        struct passwd pw, *res = NULL;
+        char buf[1024];
+        if (getpwuid_r(uid, &pw, buf, sizeof(buf), &res) == 0 && res)
+            name = g_strdup(res->pw_name);
+        else
+            name = g_strdup_printf("%u", (unsigned)uid);
+        g_hash_table_insert(user_names, GUINT_TO_POINTER(uid), name);
+    }
+    g_mutex_unlock(&user_lock);
+    return name;    // 只增不删，返回的指针一直有效
+}
+
+// /proc/PID/cmdline 以 '\0' 分隔参数，换成空格；内核线程没有 cmdline
+int get_proc_cmdline(int pid, char* buf, size_t size)
+{
+    char path[300];
+    snprintf(path, sizeof(path), "%s/%d/cmdline", proc_root, pid);
+    ssize_t n = read_file(path, buf, size);
+    if (n <= 0) {
+        buf[0] = '\0';
+        return 0;
+    }
+    while (n > 0 && buf[n - 1] == '\0') n--;
+    for (ssize_t i = 0; i < n; i++)
+        if (buf[i] == '\0') buf[i] = ' ';
+    buf[n] = '\0';
+    return 1;
+}
+
+// cgroup v2 的 "0::/path" 一行；proc_key_get 每 CGROUP_RECHECK 轮重读一次，发现进程换组时更新搜索键
+int get_proc_cgroup(int pid, char* buf, size_t size)
+{
+    char path[300];
+    char data[4096];
+    buf[0] = '\0';
+    snprintf(path, sizeof(path), "%s/%d/cgroup", proc_root, pid);
+    if (read_file(path, data, sizeof(data)) <= 0) return 0;
+
+    for (const char* p = data; p && *p; p = next_line(p)) {
+        if (strncmp(p, "0::", 3) != 0) continue;
+        const char* end = strchr(p, '\n');
+        size_t len = end ? (size_t)(end - p - 3) : strlen(p + 3);
+        if (len >= size) len = size - 1;
+        memcpy(buf, p + 3, len);
+        buf[len] = '\0';
+        return 1;
+    }
+    return 0;
+}
+
+// 返回 pid 当前的搜索键，必要时重新生成
+const ProcKey* proc_key_get(GHashTable* table, int pid, const ProcStat* ps, guint gen)
+{
+    ProcKey* pk = g_hash_table_lookup(table, GINT_TO_POINTER(pid));
+    char cgroup[CGROUP_PATH_MAX];
+    int have_cgroup = 0;
+    int rebuild = !pk || pk->starttime != ps->starttime || strcmp(pk->name, ps->name) != 0;
+
+    if (!rebuild && gen - pk->cg_gen >= CGROUP_RECHECK) {
+        get_proc_cgroup(pid, cgroup, sizeof(cgroup));
+        have_cgroup = 1;
+        pk->cg_gen = gen;
+        rebuild = kv_hash(cgroup, strlen(cgroup)) != pk->cg_hash;
+    }
+
+    if (rebuild) {
+        if (!pk) {
+            pk = g_new0(ProcKey, 1);
+            g_hash_table_insert(table, GINT_TO_POINTER(pid), pk);
+        }
+        pk->starttime = ps->starttime;
+        g_strlcpy(pk->name, ps->name, sizeof(pk->name));
+
+        char cmdline[CMDLINE_MAX];
+        get_proc_cmdline(pid, cmdline, sizeof(cmdline));
+
+        char path[300];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%d", proc_root, pid);
+        const char* user = stat(path, &st) == 0 ? get_user_name(st.st_uid) : "";
+
+        GString* key = g_string_sized_new(64);
+        if (!have_cgroup) {
+            get_proc_cgroup(pid, cgroup, sizeof(cgroup));
+            pk->cg_gen = gen - (guint)(pid % CGROUP_RECHECK);
+        }
+        pk->cg_hash = kv_hash(cgroup, strlen(cgroup));
+
+        search_key_append(key, pid, ps->name, user, cgroup, cmdline);
+        g_free(pk->key);
+        pk->len = key->len - 1;
+        pk->key = g_string_free(key, FALSE);
+    }
+    pk->gen = gen;
+    return pk;
+}
+
+static gboolean proc_key_stale(gpointer key, gpointer value, gpointer user_data)
+{
+    return ((ProcKey*)value)->gen != GPOINTER_TO_UINT(user_data);
+}
+
+void proc_key_free(gpointer p)
+{
+    ProcKey* pk = p;
+    g_free(pk->key);
+    g_free(pk);
+}
+
+/* ================= 多分辨率历史 ================= */
+// 1 秒、10 秒和 1 分钟的 min/avg/max 分别保存 10 分钟、6 小时和 7 天。
+// 各层都按 time_us 分桶，与采样间隔无关：亚秒采样合并进同一秒，窗口隐藏降频时
+// 跳过的桶用下一个样本补齐（速率本来就是整段间隔的平均）。
+// rollup 在写入时增量累计，读取时不再重新聚合；所有缓冲区在启动时一次分配。
+static const struct {
+    int bucket_secs;
+    int capacity;
+} tier_specs[HISTORY_TIERS] = {
+    { 1,  600 },        // 1 秒，10 分钟
+    { 10, 6 * 360 },    // 10 秒，6 小时
+    { 60, 7 * 1440 },   // 1 分钟，7 天
+};
+
+// 缩放级别：使用哪一层、显示多少个点
+typedef struct {
+    const char* label;
+    int tier;
+    int points;
+} ZoomLevel;
+
+static const ZoomLevel zoom_levels[] = {
+    { "1 分钟",  0, 60 },
+    { "10 分钟", 0, 600 },
+    { "1 小时",  1, 360 },
+    { "6 小时",  1, 2160 },
+    { "1 天",    2, 1440 },
+    { "7 天",    2, 10080 },
+};
+
+#define HISTORY_MAX_POINTS (7 * 1440)
+
+// 绘图时把环形数据按时间顺序拷出来的暂存区
+static double draw_min[HISTORY_MAX_POINTS];
+static double draw_avg[HISTORY_MAX_POINTS];
+static double draw_max[HISTORY_MAX_POINTS];
+
+static void history_tier_init(HistoryTier* t, int bucket_secs, int capacity)
+{
+    memset(t, 0, sizeof(HistoryTier));
+    t->bucket_secs = bucket_secs;
+    t->capacity = capacity;
+    t->avg = g_new0(double, capacity);
+    t->min = g_new0(double, capacity);
+    t->max = g_new0(double, capacity);
+}
+
+void metric_history_init(MetricHistory* h)
+{
+    for (int i = 0; i < HISTORY_TIERS; i++)
+        history_tier_init(&h->tiers[i], tier_specs[i].bucket_secs, tier_specs[i].capacity);
+}
+
+static void history_tier_push(HistoryTier* t, double mn, double av, double mx)
+{
+    t->avg[t->head] = av;
+    t->min[t->head] = mn;
+    t->max[t->head] = mx;
+    t->head = (t->head + 1) % t->capacity;
+    if (t->count < t->capacity) t->count++;
+    t->pushed++;
+}
+
+void metric_history_add(MetricHistory* h, double v, gint64 time_us)
+{
+    for (int i = 0; i < HISTORY_TIERS; i++) {
+        HistoryTier* t = &h->tiers[i];
+        gint64 bucket = time_us / ((gint64)t->bucket_secs * G_USEC_PER_SEC);
+
+        // 进入新的时间桶，把上一个桶写入；中间没有样本的桶用 v 补上，保持横轴按时间均匀
+        if (t->acc_n > 0 && bucket != t->bucket) {
+            history_tier_push(t, t->acc_min, t->acc_sum / t->acc_n, t->acc_max);
+            gint64 gap = MIN(bucket - t->bucket - 1, (gint64)t->capacity);
+            for (gint64 k = 0; k < gap; k++)
+                history_tier_push(t, v, v, v);
+            t->acc_n = 0;
+        }
+        if (t->acc_n == 0) {
+            t->bucket = bucket;
+            t->acc_sum = 0.0;
+            t->acc_min = t->acc_max = v;
+        }
+        t->acc_sum += v;
+        if (v < t->acc_min) t->acc_min = v;
+        if (v > t->acc_max) t->acc_max = v;
+        t->acc_n++;
+    }
+}
+
+// 按时间顺序拷出最近 n 个点，返回实际拷出的点数
+int history_tier_copy(const HistoryTier* t, int n, double* mn, double* av, double* mx)
+{
+    if (n > t->count) n = t->count;
+    int start = (t->head - n + t->capacity) % t->capacity;
+    for (int i = 0; i < n; i++) {
+        int idx = (start + i) % t->capacity;
+        av[i] = t->avg[idx];
+        mn[i] = t->min[idx];
+        mx[i] = t->max[idx];
+    }
+    return n;
+}
+
+void perf_history_init(PerfHistory* p)
+{
+    metric_history_init(&p->cpu);
+    metric_history_init(&p->mem);
+    metric_history_init(&p->disk);
+    for (int i = 0; i < PSI_RES; i++)
+        metric_history_init(&p->psi[i]);
+    metric_history_init(&p->net);
+}
+
+static void metric_history_clear(MetricHistory* h)
+{
+    for (int i = 0; i < HISTORY_TIERS; i++) {
+        HistoryTier* t = &h->tiers[i];
+        t->count = t->head = t->acc_n = 0;
+    }
+}
+
+void perf_history_reset(PerfHistory* p)
+{
+    MetricHistory* all[] = { &p->cpu, &p->mem, &p->disk, &p->psi[PSI_CPU], &p->psi[PSI_MEM], &p->psi[PSI_IO], &p->net };
+    for (int m = 0; m < (int)G_N_ELEMENTS(all); m++)
+        metric_history_clear(all[m]);
+    for (int i = 0; i < DISK_MAX_DEVS; i++)
+        if (p->disk_dev[i]) metric_history_clear(p->disk_dev[i]);
+    p->epoch++;
+}
+
+// 磁盘设备的历史按名字占用槽位：先找同名的，再用空槽，都没有时回收本轮不存在的设备。
+// 返回新分配的槽位数，历史占用的内存随之增加
+int disk_history_add(PerfHistory* p, const SystemSnapshot* sys, gint64 time_us)
+{
+    int allocated = 0;
+    for (int i = 0; i < sys->n_disks; i++) {
+        const DiskRate* r = &sys->disks[i];
+        int slot = -1;
+        for (int k = 0; k < DISK_MAX_DEVS && slot < 0; k++)
+            if (p->disk_dev[k] && strcmp(p->disk_dev_name[k], r->name) == 0) slot = k;
+        for (int k = 0; k < DISK_MAX_DEVS && slot < 0; k++) {
+            if (p->disk_dev[k]) continue;
+            p->disk_dev[k] = g_new0(MetricHistory, 1);
+            metric_history_init(p->disk_dev[k]);
+            allocated++;
+            slot = k;
+        }
+        for (int k = 0; k < DISK_MAX_DEVS && slot < 0; k++) {
+            int present = 0;
+            for (int j = 0; j < sys->n_disks && !present; j++)
+                present = strcmp(p->disk_dev_name[k], sys->disks[j].name) == 0;
+            if (present) continue;
+            metric_history_clear(p->disk_dev[k]);
+            slot = k;
+        }
+        if (slot < 0) continue;
+        memcpy(p->disk_dev_name[slot], r->name, DISK_NAME_MAX);
+        metric_history_add(p->disk_dev[slot], r->read_kb + r->write_kb, time_us);
+    }
+    return allocated;
+}
+
+static MetricHistory* disk_history_find(PerfHistory* p, const char* name)
+{
+    for (int k = 0; k < DISK_MAX_DEVS; k++)
+        if (p->disk_dev[k] && strcmp(p->disk_dev_name[k], name) == 0) return p->disk_dev[k];
+    return NULL;
+}
+
+// 历史数据占用的内存，只在磁盘设备第一次出现时增加
+size_t perf_history_bytes()
+{
+    size_t per_metric = 0;
+    int n = 4 + PSI_RES;
+    for (int i = 0; i < HISTORY_TIERS; i++)
+        per_metric += (size_t)tier_specs[i].capacity * 3 * sizeof(double);
+    for (int i = 0; i < DISK_MAX_DEVS; i++)
+        if (perf_history.disk_dev[i]) n++;
+    return per_metric * n + sizeof(draw_min) + sizeof(draw_avg) + sizeof(draw_max);
+}
+
+/* ================= 绘图函数 ================= */
+// 画一条折线，n 个点靠右对齐，x 轴共 total 个点；fill 是按高度缓存的渐变
+void draw_perf_line(cairo_t* cr, const double* data_array, int n, int total, int h, double dx, double r, double g, double b, double scale, cairo_pattern_t* fill)
+{
+    if (n <= 0) return;
+    double x0 = (total - n) * dx;
+
+    cairo_save(cr);
+    cairo_move_to(cr, x0, h);
+    for (int i = 0; i < n; i++) 
+    {
+        double y = h * (1.0 - data_array[i] / scale);
+        if (y < 0) y = 0;
+        cairo_line_to(cr, x0 + i * dx, y);
+    }
+    cairo_line_to(cr, x0 + (n - 1) * dx, h);
+    cairo_line_to(cr, x0, h);
+    cairo_close_path(cr);
+
+    cairo_set_source(cr, fill);
+    cairo_fill(cr);
+    cairo_restore(cr);
+
+    cairo_set_source_rgb(cr, r, g, b);
+    for (int i = 0; i < n; i++) {
+        double y = h * (1.0 - data_array[i] / scale);
+        if (y < 0) y = 0;
+        if (i == 0) cairo_move_to(cr, x0, y);
+        else cairo_line_to(cr, x0 + i * dx, y);
+    }
+    cairo_stroke(cr);
+}
+
+// 在平均线后面画出每个桶 min~max 的范围带
+void draw_perf_band(cairo_t* cr, const double* mn, const double* mx, int n, int total, int h, double dx, double r, double g, double b, double scale)
+{
+    if (n <= 0) return;
+    double x0 = (total - n) * dx;
+
+    cairo_save(cr);
+    for (int i = 0; i < n; i++) {
+        double y = h * (1.0 - mx[i] / scale);
+        if (y < 0) y = 0;
+        if (i == 0) cairo_move_to(cr, x0, y);
+        else cairo_line_to(cr, x0 + i * dx, y);
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        double y = h * (1.0 - mn[i] / scale);
+        if (y < 0) y = 0;
+        cairo_line_to(cr, x0 + i * dx, y);
+    }
+    cairo_close_path(cr);
+    cairo_set_source_rgba(cr, r, g, b, 0.25);
+    cairo_fill(cr);
+    cairo_restore(cr);
+}
+
+typedef struct {
+    double r, g, b;
+    double scale;
+} GraphStyle;
+
+static const GraphStyle graph_styles[] = {
+    [PERF_CPU]  = { 0.3,  0.6, 1.0, 100.0 },
+    [PERF_MEM]  = { 0.05, 0.2, 0.6, 100.0 },
+    [PERF_DISK] = { 0.3,  0.8, 0.6, 1024.0 },
+    [PERF_PSI_CPU] = { 0.3, 0.6, 1.0, 100.0 },
+    [PERF_PSI_MEM] = { 0.6, 0.3, 0.9, 100.0 },
+    [PERF_PSI_IO]  = { 0.3, 0.8, 0.6, 100.0 },
+    [PERF_NET]  = { 0.9, 0.6, 0.2, 1024.0 },
+};
+
+// 每张图一份离屏缓存：新样本到来时把旧图左移，只重画右侧新露出的一条
+typedef struct {
+    cairo_surface_t* surface;   // 当前画面
+    cairo_surface_t* back;      // 滚动时的目标，画完与 surface 交换
+    int w, h;
+    int zoom;
+    guint epoch;                // 对应 perf_history.epoch，历史被重置后整图重画
+    guint64 drawn;              // 已画到 tier->pushed 的哪个点
+    double shift_acc;           // 还没滚动的小数像素，留到下次
+
+    cairo_pattern_t* fill;      // 折线下方的渐变，只随高度变化
+    int fill_h;
+} GraphCache;
+
+static GraphCache graph_cache[PERF_TYPES];
+
+static const MetricHistory* graph_metric(PerfType type)
+{
+    switch (type) {
+    case PERF_MEM: return &perf_history.mem;
+    case PERF_DISK: {
+        // 选中的设备还没有历史（或已被回收）时显示合计
+        MetricHistory* h = disk_selected[0] ? disk_history_find(&perf_history, disk_selected) : NULL;
+        return h ? h : &perf_history.disk;
+    }
+    case PERF_PSI_CPU: return &perf_history.psi[PSI_CPU];
+    case PERF_PSI_MEM: return &perf_history.psi[PSI_MEM];
+    case PERF_PSI_IO: return &perf_history.psi[PSI_IO];
+    case PERF_NET: return &perf_history.net;
+    default: return &perf_history.cpu;
+    }
+}
+
+static cairo_pattern_t* graph_fill(PerfType type, int h)
+{
+    GraphCache* gc = &graph_cache[type];
+    if (gc->fill && gc->fill_h == h) return gc->fill;
+
+    const GraphStyle* st = &graph_styles[type];
+    if (gc->fill) cairo_pattern_destroy(gc->fill);
+    gc->fill = cairo_pattern_create_linear(0, 0, 0, h);
+    cairo_pattern_add_color_stop_rgba(gc->fill, 0.0, st->r, st->g, st->b, 0.40); // 顶部alpha
+    cairo_pattern_add_color_stop_rgba(gc->fill, 1.0, st->r, st->g, st->b, 0.35); // 底部alpha
+    gc->fill_h = h;
+    return gc->fill;
+}
+
+static void graph_background(cairo_t* cr)
+{
+    /* ===== 背景 ===== */
+    cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+    cairo_paint(cr);
+
+    /* 线条更圆润 */
+    cairo_set_line_width(cr, 2.0);
+    cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+}
+
+// 画当前缩放级别的最近 last 个点，last 为 0 时画全部
+void draw_history(cairo_t* cr, PerfType type, int w, int h, int last)
+{
+    const GraphStyle* st = &graph_styles[type];
+    const ZoomLevel* z = &zoom_levels[perf_zoom];
+    const HistoryTier* t = &graph_metric(type)->tiers[z->tier];
+    double dx = (double)w / (z->points - 2);
+
+    int want = last > 0 ? MIN(last, z->points) : z->points;
+    int n = history_tier_copy(t, want, draw_min, draw_avg, draw_max);
+    // 每秒只有一个样本时 min/max 重合，范围带不占面积
+    draw_perf_band(cr, draw_min, draw_max, n, z->points, h, dx, st->r, st->g, st->b, st->scale);
+    draw_perf_line(cr, draw_avg, n, z->points, h, dx, st->r, st->g, st->b, st->scale, graph_fill(type, h));
+}
+
+// 整图重画，不使用离屏缓存（界面基准也用它）
+void draw_perf_graph(cairo_t* cr, int w, int h, PerfType type)
+{
+    graph_background(cr);
+    draw_history(cr, type, w, h, 0);
+}
+
+gboolean draw_performance(GtkWidget* widget, cairo_t* cr, gpointer data)
+{
+    PerfType type = GPOINTER_TO_INT(data);
+    GraphCache* gc = &graph_cache[type];
+    int w = gtk_widget_get_allocated_width(widget);
+    int h = gtk_widget_get_allocated_height(widget);
+
+    const ZoomLevel* z = &zoom_levels[perf_zoom];
+    const HistoryTier* t = &graph_metric(type)->tiers[z->tier];
+    double dx = (double)w / (z->points - 2);
+
+    if (!gc->surface || gc->w != w || gc->h != h) {
+        if (gc->surface) cairo_surface_destroy(gc->surface);
+        if (gc->back) cairo_surface_destroy(gc->back);
+        GdkWindow* win = gtk_widget_get_window(widget);
+        gc->surface = gdk_window_create_similar_surface(win, CAIRO_CONTENT_COLOR, w, h);
+        gc->back = gdk_window_create_similar_surface(win, CAIRO_CONTENT_COLOR, w, h);
+        gc->w = w;
+        gc->h = h;
+        gc->epoch = perf_history.epoch - 1;     // 强制整图重画
+    }
+
+    guint64 steps = t->pushed - gc->drawn;
+    int full = gc->epoch != perf_history.epoch || gc->zoom != perf_zoom ||
+        t->pushed < gc->drawn || steps * dx >= w;
+
+    if (full) {
+        cairo_t* sc = cairo_create(gc->surface);
+        draw_perf_graph(sc, w, h, type);
+        cairo_destroy(sc);
+        gc->shift_acc = 0;
+    }
+    else if (steps > 0) {
+        // 按整像素左移，小数部分累计到下次
+        gc->shift_acc += steps * dx;
+        int shift = (int)gc->shift_acc;
+        gc->shift_acc -= shift;
+
+        cairo_t* sc = cairo_create(gc->back);
+        cairo_set_operator(sc, CAIRO_OPERATOR_SOURCE);
+        cairo_set_source_surface(sc, gc->surface, -shift, 0);
+        cairo_paint(sc);
+        cairo_set_operator(sc, CAIRO_OPERATOR_OVER);
+
+        // 右侧露出的一条连同线宽和圆角的余量一起清空重画，覆盖它的点都要画上
+        double strip = shift + 4.0;
+        cairo_rectangle(sc, w - strip, 0, strip, h);
+        cairo_clip(sc);
+        graph_background(sc);
+        draw_history(sc, type, w, h, (int)(strip / dx) + 3);
+        cairo_destroy(sc);
+
+        cairo_surface_t* tmp = gc->surface;
+        gc->surface = gc->back;
+        gc->back = tmp;
+    }
+    gc->zoom = perf_zoom;
+    gc->epoch = perf_history.epoch;
+    gc->drawn = t->pushed;
+
+    cairo_set_source_surface(cr, gc->surface, 0, 0);
+    cairo_paint(cr);
+    return FALSE;
+}
+
+/* ================= 每核网格 ================= */
+// 每个逻辑核一个格子：背景颜色表示当前占用，格子里画最近 CORE_HISTORY 个点的折线
+#define CORE_HISTORY 30
+#define CORE_HEAT_LEVELS 8
+
+static int core_count = 0;
+static float* core_history = NULL;      // core_history[核 * CORE_HISTORY + 点]，每核一段环形
+static int core_hist_head = 0;
+static int core_hist_len = 0;
+
+void core_history_reset()
+{
+    core_hist_head = 0;
+    core_hist_len = 0;
+}
+
+void core_history_add(const float* usage, int n)
+{
+    if (n != core_count) {
+        g_free(core_history);
+        core_history = g_new0(float, (size_t)n * CORE_HISTORY);
+        core_count = n;
+        core_history_reset();
+    }
+    for (int i = 0; i < n; i++)
+        core_history[i * CORE_HISTORY + core_hist_head] = usage[i];
+    core_hist_head = (core_hist_head + 1) % CORE_HISTORY;
+    if (core_hist_len < CORE_HISTORY) core_hist_len++;
+}
+
+// 一次画完所有核：同一热度的格子合成一条路径填充，所有折线合成一条路径描边，
+// 绘制调用次数与核数无关
+void draw_core_cells(cairo_t* cr, int w, int h)
+{
+    cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+    cairo_paint(cr);
+    if (core_count == 0 || core_hist_len == 0) return;
+
+    // 列数按宽高比选，让格子接近正方形
+    int cols = 1;
+    while (cols < core_count && (double)cols * cols * MAX(h, 1) < (double)core_count * w)
+        cols++;
+    int rows = (core_count + cols - 1) / cols;
+    double cw = (double)w / cols;
+    double ch = (double)h / rows;
+    double pad = cw > 8 && ch > 8 ? 2.0 : 0.0;
+    int last = (core_hist_head + CORE_HISTORY - 1) % CORE_HISTORY;
+
+    for (int level = 0; level < CORE_HEAT_LEVELS; level++) {
+        int any = 0;
+        for (int i = 0; i < core_count; i++) {
+            float u = core_history[i * CORE_HISTORY + last];
+            int l = CLAMP((int)(u * CORE_HEAT_LEVELS / 100.0f), 0, CORE_HEAT_LEVELS - 1);
+            if (l != level) continue;
+            cairo_rectangle(cr, (i % cols) * cw + pad / 2, (i / cols) * ch + pad / 2, cw - pad, ch - pad);
+            any = 1;
+        }
+        if (!any) continue;
+        // 空闲偏蓝，满载偏红
+        double t = (level + 0.5) / CORE_HEAT_LEVELS;
+        cairo_set_source_rgb(cr, 0.12 + 0.55 * t, 0.16 + 0.04 * t, 0.25 - 0.15 * t);
+        cairo_fill(cr);
+    }
+
+    double dx = (cw - pad) / (CORE_HISTORY - 1);
+    int start = (core_hist_head - core_hist_len + CORE_HISTORY) % CORE_HISTORY;
+    for (int i = 0; i < core_count; i++) {
+        double x0 = (i % cols) * cw + pad / 2 + (CORE_HISTORY - core_hist_len) * dx;
+        double y0 = (i / cols) * ch + pad / 2;
+        const float* hist = core_history + i * CORE_HISTORY;
+        for (int k = 0; k < core_hist_len; k++) {
+            double y = y0 + (ch - pad) * (1.0 - hist[(start + k) % CORE_HISTORY] / 100.0);
+            if (k == 0) cairo_move_to(cr, x0, y);
+            else cairo_line_to(cr, x0 + k * dx, y);
+        }
+    }
+    cairo_set_source_rgb(cr, 0.3, 0.6, 1.0);
+    cairo_set_line_width(cr, 1.0);
+    cairo_stroke(cr);
+}
+
+gboolean draw_core_grid(GtkWidget* widget, cairo_t* cr, gpointer data)
+{
+    draw_core_cells(cr, gtk_widget_get_allocated_width(widget), gtk_widget_get_allocated_height(widget));
+    return FALSE;
+}
+
+/* ================= 网络接口小图 ================= */
+// 每个接口一行：左边是数字，右边是最近 NET_SPARK_POINTS 轮的收发折线。
+// 小图按接口名占用固定槽位，接口消失后槽位空出来给新接口，不随接口增删分配内存
+#define NET_SPARK_POINTS 60
+#define NET_ROW_H 44
+#define NET_SPARK_H (NET_ROW_H - 8)
+#define NET_TEXT_W 360
+
+typedef struct {
+    char name[NET_NAME_MAX];
+    int used;
+    double rx[NET_SPARK_POINTS];    // 环形，写入位置与 net_spark_head 一致
+    double tx[NET_SPARK_POINTS];
+} NetSpark;
+
+static NetSpark net_sparks[NET_MAX_IFACES];
+static int net_spark_head = 0;
+static int net_spark_len = 0;
+static NetRate net_shown[NET_MAX_IFACES];       // 最近一轮的接口，绘制时使用
+static int net_shown_slot[NET_MAX_IFACES];
+static int net_shown_n = 0;
+
+void net_spark_reset()
+{
+    memset(net_sparks, 0, sizeof(net_sparks));
+    net_spark_head = 0;
+    net_spark_len = 0;
+    net_shown_n = 0;
+}
+
+void net_spark_add(const SystemSnapshot* sys)
+{
+    int seen[NET_MAX_IFACES] = { 0 };
+
+    // 先认领已有的槽位，释放消失的接口，再给新接口分配，接口数不超过槽位数
+    for (int i = 0; i < sys->n_net; i++) {
+        net_shown_slot[i] = -1;
+        for (int k = 0; k < NET_MAX_IFACES; k++) {
+            if (net_sparks[k].used && !seen[k] && strcmp(net_sparks[k].name, sys->net[i].name) == 0) {
+                net_shown_slot[i] = k;
+                seen[k] = 1;
+                break;
+            }
+        }
+    }
+    for (int k = 0; k < NET_MAX_IFACES; k++)
+        if (!seen[k]) net_sparks[k].used = 0;
+
+    for (int i = 0; i < sys->n_net; i++) {
+        const NetRate* r = &sys->net[i];
+        int slot = net_shown_slot[i];
+        for (int k = 0; slot < 0; k++) {
+            if (net_sparks[k].used) continue;
+            memset(&net_sparks[k], 0, sizeof(NetSpark));
+            memcpy(net_sparks[k].name, r->name, NET_NAME_MAX);
+            net_sparks[k].used = 1;
+            slot = net_shown_slot[i] = k;
+        }
+        net_sparks[slot].rx[net_spark_head] = r->rx_kb;
+        net_sparks[slot].tx[net_spark_head] = r->tx_kb;
+        net_shown[i] = *r;
+    }
+
+    net_shown_n = sys->n_net;
+    net_spark_head = (net_spark_head + 1) % NET_SPARK_POINTS;
+    if (net_spark_len < NET_SPARK_POINTS) net_spark_len++;
+}
+
+// 接收蓝色、发送橙色；小图高度固定，渐变创建一次
+static const double net_spark_rgb[2][3] = { { 0.3, 0.6, 1.0 }, { 0.9, 0.6, 0.2 } };
+
+static cairo_pattern_t* net_spark_fill(int tx)
+{
+    static cairo_pattern_t* fill[2];
+    if (!fill[tx]) {
+        const double* c = net_spark_rgb[tx];
+        fill[tx] = cairo_pattern_create_linear(0, 0, 0, NET_SPARK_H);
+        cairo_pattern_add_color_stop_rgba(fill[tx], 0.0, c[0], c[1], c[2], 0.30);
+        cairo_pattern_add_color_stop_rgba(fill[tx], 1.0, c[0], c[1], c[2], 0.20);
+    }
+    return fill[tx];
+}
+
+void draw_net_rows(cairo_t* cr, int w, int h)
+{
+    cairo_set_source_rgb(cr, 0.1, 0.1, 0.1);
+    cairo_paint(cr);
+    if (net_shown_n == 0) return;
+
+    PangoLayout* layout = pango_cairo_create_layout(cr);
+    double rx[NET_SPARK_POINTS], tx[NET_SPARK_POINTS];
+    int start = (net_spark_head - net_spark_len + NET_SPARK_POINTS) % NET_SPARK_POINTS;
+    int spark_w = w - NET_TEXT_W - 10;
+    double dx = spark_w > 0 ? (double)spark_w / (NET_SPARK_POINTS - 1) : 0;
+
+    cairo_set_line_width(cr, 1.0);
+    for (int i = 0; i < net_shown_n; i++) {
+        const NetRate* r = &net_shown[i];
+        double y0 = i * NET_ROW_H;
+
+        // 接口名可以含 & < 之类的字符，必须转义后再放进标记
+        char* markup = g_markup_printf_escaped(
+            "<b>%s</b>   错误 %llu (%.1f/s)   丢包 %llu (%.1f/s)\n"
+            "接收 %.1f KB/s  %.0f 包/s   发送 %.1f KB/s  %.0f 包/s",
+            r->name, r->errs, r->errs_ps, r->drops, r->drop_ps,
+            r->rx_kb, r->rx_pps, r->tx_kb, r->tx_pps);
+        pango_layout_set_markup(layout, markup, -1);
+        g_free(markup);
+        cairo_set_source_rgb(cr, 0.85, 0.85, 0.85);
+        cairo_move_to(cr, 6, y0 + 4);
+        pango_cairo_show_layout(cr, layout);
+
+        if (dx <= 0 || net_spark_len == 0) continue;
+
+        // 每个接口按自己最近的峰值缩放，收发共用一个刻度
+        const NetSpark* sp = &net_sparks[net_shown_slot[i]];
+        double peak = 1.0;
+        for (int k = 0; k < net_spark_len; k++) {
+            rx[k] = sp->rx[(start + k) % NET_SPARK_POINTS];
+            tx[k] = sp->tx[(start + k) % NET_SPARK_POINTS];
+            peak = MAX(peak, MAX(rx[k], tx[k]));
+        }
+
+        cairo_save(cr);
+        cairo_translate(cr, NET_TEXT_W, y0 + 4);
+        cairo_rectangle(cr, 0, 0, spark_w, NET_SPARK_H);
+        cairo_clip(cr);
+        const double* rc = net_spark_rgb[0];
+        const double* tc = net_spark_rgb[1];
+        draw_perf_line(cr, rx, net_spark_len, NET_SPARK_POINTS, NET_SPARK_H, dx, rc[0], rc[1], rc[2], peak * 1.1, net_spark_fill(0));
+        draw_perf_line(cr, tx, net_spark_len, NET_SPARK_POINTS, NET_SPARK_H, dx, tc[0], tc[1], tc[2], peak * 1.1, net_spark_fill(1));
+        cairo_restore(cr);
+    }
+    g_object_unref(layout);
+}
+
+gboolean draw_net_iface_rows(GtkWidget* widget, cairo_t* cr, gpointer data)
+{
+    draw_net_rows(cr, gtk_widget_get_allocated_width(widget), gtk_widget_get_allocated_height(widget));
+    return FALSE;
+}
+
+/* ================= 后台采集 ================= */
+// 以下函数只在采集线程中运行，不能调用任何 GTK 接口
+
+/* ================= 并行进程扫描 ================= */
+// PID 按 pid % n_shards 固定分到各分片，每个分片有自己的 cpu/io 增量表和 fd 缓存。
+// worker 从共享计数器上领取分片，快的 worker 自然多领；同一分片同一时刻只有一个
+// worker 处理，热路径上没有锁。每个 worker 把结果写进自己的数组，最后合并。
+
+// 每个进程的 CPU/IO 增量基准。按 (pid, starttime) 识别进程：PID 被复用时 starttime
+// 不同，旧基准作废，新进程不会被算上旧进程的计数。
+typedef struct ProcTrack {
+    unsigned long long starttime;
+    guint gen;                  // 最近一次扫到的轮次，落后的在本轮结束时回收
+    gboolean has_io;            // io 是否是上一轮的有效基准
+    ProcCpu cpu;
+    ProcIO io;
+    struct ProcTrack* next_free;
+} ProcTrack;
+
+// 条目成块分配，回收后挂在空闲链表上复用。短命进程不断出现和退出时没有 malloc/free，
+// 占用的内存停在进程数的峰值。
+#define TRACK_BLOCK 256
+
+typedef struct {
+    ProcTrack* free_list;
+    GPtrArray* blocks;
+    int allocated;
+} TrackPool;
+
+typedef struct {
+    GHashTable* track_table;    // pid -> ProcTrack，条目属于 tracks
+    TrackPool tracks;
+    GHashTable* key_table;      // pid -> ProcKey
+    FdCache fds;
+    GArray* pids;               // 本轮分到该分片的 PID
+} ProcShard;
+
+typedef struct {
+    long long sys_total;        // 本轮系统 CPU 总时间
+    gint64 time_us;
+    long long mem_total;
+    long page_kb;
+    int need;
+} ScanCtx;
+
+static int scan_workers = 0;            // 扫描线程数，0 表示按 CPU 核数
+static int scan_inline_pids = 2048;     // PID 少于此数时直接在采集线程里扫描
+
+ProcShard* proc_shards;
+int n_shards;
+int n_workers;
+int max_workers;
+GArray** worker_rows;                   // 每个 worker 的结果数组
+GString** worker_keys;                  // 每个 worker 的搜索键，key_off 相对于它
+GThreadPool* scan_pool;
+
+static ScanCtx scan_ctx;
+static gint next_shard;
+static int scan_pending;
+static GMutex scan_lock;
+static GCond scan_done;
+
+static ProcTrack* track_pool_alloc(TrackPool* pool)
+{
+    if (!pool->free_list) {
+        ProcTrack* block = g_new(ProcTrack, TRACK_BLOCK);
+        g_ptr_array_add(pool->blocks, block);
+        for (int i = 0; i < TRACK_BLOCK; i++) {
+            block[i].next_free = pool->free_list;
+            pool->free_list = &block[i];
+        }
+        pool->allocated += TRACK_BLOCK;
+    }
+    ProcTrack* t = pool->free_list;
+    pool->free_list = t->next_free;
+    return t;
+}
+
+static void track_pool_free(TrackPool* pool, ProcTrack* t)
+{
+    t->next_free = pool->free_list;
+    pool->free_list = t;
+}
+
+// 返回 pid 的增量状态；新进程或 PID 被复用时清空基准
+static ProcTrack* proc_track_get(ProcShard* sh, int pid, unsigned long long starttime, guint gen)
+{
+    ProcTrack* t = g_hash_table_lookup(sh->track_table, GINT_TO_POINTER(pid));
+    if (!t) {
+        t = track_pool_alloc(&sh->tracks);
+        g_hash_table_insert(sh->track_table, GINT_TO_POINTER(pid), t);
+        memset(t, 0, sizeof(*t));
+        t->starttime = starttime;
+    }
+    else if (t->starttime != starttime) {
+        memset(t, 0, sizeof(*t));
+        t->starttime = starttime;
+    }
+    t->gen = gen;
+    return t;
+}
+
+// 回收本轮没有扫到（已退出）的条目，键由表自己的销毁函数释放
+static void track_table_sweep(GHashTable* table, TrackPool* pool, guint gen)
+{
+    GHashTableIter it;
+    gpointer value;
+    g_hash_table_iter_init(&it, table);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        ProcTrack* t = value;
+        if (t->gen == gen) continue;
+        g_hash_table_iter_remove(&it);
+        track_pool_free(pool, t);
+    }
+}
+
+// 按上次采样以来 utime+stime 的增量计算 CPU%，并把 base 更新为本次的值；
+// base->sys_total 为 0 表示还没有基准，返回 0；计数变小说明对象被替换过，也从头算。
+// 进程、线程和 cgroup 共用
+double proc_cpu_step(ProcCpu* base, long long utime, long long stime, long long sys_total)
+{
+    double cpu = 0.0;
+    // 分母用上次采样以来的系统时间差，进程列表暂停采集一段时间后恢复也不会偏大
+    if (base->sys_total > 0 && sys_total > base->sys_total) {
+        long long delta = (utime + stime) - (base->utime + base->stime);
+        if (delta > 0)
+            cpu = (double)delta / (sys_total - base->sys_total) * 100.0;
+    }
+    base->utime = utime;
+    base->stime = stime;
+    base->sys_total = sys_total;
+    return cpu;
+}
+
+// 按上次的 io 基准算读写速率（KB/s）并更新基准，没有基准时为 0。进程和 cgroup 共用
+void proc_io_step(ProcTrack* t, const ProcIO* io, double* read_kb, double* write_kb)
+{
+    *read_kb = *write_kb = 0.0;
+    if (t->has_io && io->read_bytes >= t->io.read_bytes && io->write_bytes >= t->io.write_bytes) {
+        double secs = (io->time_us - t->io.time_us) / (double)G_USEC_PER_SEC;
+        if (secs > 0) {
+            *read_kb = (io->read_bytes - t->io.read_bytes) / 1024.0 / secs;
+            *write_kb = (io->write_bytes - t->io.write_bytes) / 1024.0 / secs;
+        }
+    }
+    t->io = *io;
+    t->has_io = TRUE;
+}
+
+// 以 id 为键的 proc_cpu_step，线程视图用
+double proc_cpu_delta(GHashTable* table, int id, long long utime, long long stime, long long sys_total)
+{
+    ProcCpu* base = g_hash_table_lookup(table, GINT_TO_POINTER(id));
+    if (!base) {
+        base = g_new0(ProcCpu, 1);
+        g_hash_table_insert(table, GINT_TO_POINTER(id), base);
+    }
+    return proc_cpu_step(base, utime, stime, sys_total);
+}
+
+void scan_pid(ProcShard* sh, int pid, const ScanCtx* ctx, GArray* out, GString* keys)
+{
+    ProcRow row;
+    row.pid = pid;
+
+    ProcStat ps;
+    if (!get_proc_stat(&sh->fds, pid, &ps)) return;
+    g_strlcpy(row.name, ps.name, sizeof(row.name));
+    row.ppid = ps.ppid;
+
+    const ProcKey* pk = proc_key_get(sh->key_table, pid, &ps, sh->fds.gen);
+    row.key_off = keys->len;
+    g_string_append_len(keys, pk->key, pk->len + 1);
+
+    ProcTrack* t = proc_track_get(sh, pid, ps.starttime, sh->fds.gen);
+
+    // ---- CPU ----
+    row.cpu = proc_cpu_step(&t->cpu, ps.utime, ps.stime, ctx->sys_total);
+
+    // ---- MEM ----
+    row.mem = ctx->mem_total ? 100.0 * ps.rss_pages * ctx->page_kb / ctx->mem_total : 0.0;
+
+    // ---- IO ----
+    // 本轮没读到 io 时基准作废，I/O 列重新打开后不会拿很久以前的值算速率
+    ProcIO io = { 0 };
+    row.io_kb = 0.0;
+    if ((ctx->need & PROC_NEED_IO) && get_proc_io(&sh->fds, pid, &io)) {
+        double read_kb, write_kb;
+        io.time_us = ctx->time_us;
+        proc_io_step(t, &io, &read_kb, &write_kb);
+        row.io_kb = read_kb + write_kb;
+    }
+    else {
+        t->has_io = FALSE;
+    }
+
+    g_array_append_val(out, row);
+}
+
+void scan_shard(ProcShard* sh, GArray* out, GString* keys)
+{
+    fd_cache_begin_tick(&sh->fds);
+    for (guint i = 0; i < sh->pids->len; i++)
+        scan_pid(sh, g_array_index(sh->pids, int, i), &scan_ctx, out, keys);
+    fd_cache_sweep(&sh->fds);
+    track_table_sweep(sh->track_table, &sh->tracks, sh->fds.gen);
+    g_hash_table_foreach_remove(sh->key_table, proc_key_stale, GUINT_TO_POINTER(sh->fds.gen));
+}
+
+// 不断领取下一个分片直到全部处理完
+void scan_claim_shards(int w)
+{
+    int i;
+    while ((i = g_atomic_int_add(&next_shard, 1)) < n_shards)
+        scan_shard(&proc_shards[i], worker_rows[w], worker_keys[w]);
+}
+
+void scan_worker(gpointer data, gpointer user_data)
+{
+    int w = GPOINTER_TO_INT(data) - 1;
+    scan_claim_shards(w);
+
+    g_mutex_lock(&scan_lock);
+    if (--scan_pending == 0)
+        g_cond_signal(&scan_done);
+    g_mutex_unlock(&scan_lock);
+}
+
+void proc_scan_set_workers(int workers)
+{
+    n_workers = workers > 0 ? MIN(workers, max_workers) : max_workers;
+    g_thread_pool_set_max_threads(scan_pool, n_workers, NULL);
+}
+
+void proc_scan_init(int workers)
+{
+    int ncpu = g_get_num_processors();
+
+    // 分片数与 worker 数无关，改变 worker 数时增量状态不受影响
+    n_shards = MAX(16, ncpu * 4);
+    proc_shards = g_new0(ProcShard, n_shards);
+
+    fd_budget_total = fd_cache_total_budget(fd_cache_limit);
+    if (fd_budget_total == 0)
+        g_message("RLIMIT_NOFILE 软上限太低，/proc 文件描述符缓存已关闭");
+    for (int i = 0; i < n_shards; i++) {
+        proc_shards[i].track_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+        proc_shards[i].tracks.blocks = g_ptr_array_new_with_free_func(g_free);
+        proc_shards[i].key_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, proc_key_free);
+        proc_shards[i].pids = g_array_new(FALSE, FALSE, sizeof(int));
+        fd_cache_init(&proc_shards[i].fds);
+    }
+
+    max_workers = MAX(ncpu, workers);
+    worker_rows = g_new0(GArray*, max_workers);
+    worker_keys = g_new0(GString*, max_workers);
+    for (int w = 0; w < max_workers; w++) {
+        worker_rows[w] = g_array_new(FALSE, FALSE, sizeof(ProcRow));
+        worker_keys[w] = g_string_new(NULL);
+    }
+
+    scan_pool = g_thread_pool_new(scan_worker, NULL, 1, TRUE, NULL);
+    proc_scan_set_workers(workers);
+}
+
+// 需要先采集 s->sys
+void collect_process_rows(Snapshot* s)
+{
+    gint64 t0 = g_get_monotonic_time();
+
+    scan_ctx.sys_total = s->sys.cpu.total;
+    scan_ctx.time_us = s->time_us;
+    scan_ctx.mem_total = s->sys.mem.mem_total;
+    scan_ctx.page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+    // 只读取可见列需要的额外文件
+    scan_ctx.need = g_atomic_int_get(&proc_need_mask);
+
+    for (int i = 0; i < n_shards; i++)
+        g_array_set_size(proc_shards[i].pids, 0);
+
+    DIR* dir = opendir(proc_root);
+    if (!dir) {
+        s->procs = g_array_new(FALSE, FALSE, sizeof(ProcRow));
+        s->keys = g_string_new(NULL);
+        return;
+    }
+
+    struct dirent* e;
+    int npids = 0;
+    while ((e = readdir(dir))) {
+        if (!is_pid_dir(e->d_name)) continue;
+        int pid = atoi(e->d_name);
+        g_array_append_val(proc_shards[pid % n_shards].pids, pid);
+        npids++;
+    }
+    closedir(dir);
+
+    for (int w = 0; w < n_workers; w++) {
+        g_array_set_size(worker_rows[w], 0);
+        g_string_truncate(worker_keys[w], 0);
+    }
+    g_atomic_int_set(&next_shard, 0);
+
+    int used = (npids < scan_inline_pids || n_workers <= 1) ? 1 : n_workers;
+    if (used == 1) {
+        scan_claim_shards(0);
+    }
+    else {
+        g_mutex_lock(&scan_lock);
+        scan_pending = used;
+        for (int w = 0; w < used; w++)
+            g_thread_pool_push(scan_pool, GINT_TO_POINTER(w + 1), NULL);
+        while (scan_pending > 0)
+            g_cond_wait(&scan_done, &scan_lock);
+        g_mutex_unlock(&scan_lock);
+    }
+
+    // 合并各 worker 的结果，搜索键的偏移改为相对于合并后的缓冲区
+    gsize key_bytes = 0;
+    for (int w = 0; w < used; w++)
+        key_bytes += worker_keys[w]->len;
+    s->procs = g_array_sized_new(FALSE, FALSE, sizeof(ProcRow), npids);
+    s->keys = g_string_sized_new(key_bytes);
+    for (int w = 0; w < used; w++) {
+        guint first = s->procs->len;
+        guint32 base = (guint32)s->keys->len;
+        g_array_append_vals(s->procs, worker_rows[w]->data, worker_rows[w]->len);
+        g_string_append_len(s->keys, worker_keys[w]->str, worker_keys[w]->len);
+        for (guint i = first; i < s->procs->len; i++)
+            g_array_index(s->procs, ProcRow, i).key_off += base;
+    }
+
+    s->fd_saved = 0;
+    s->fd_open = 0;
+    s->tracks_live = 0;
+    s->tracks_pooled = 0;
+    for (int i = 0; i < n_shards; i++) {
+        s->fd_saved += proc_shards[i].fds.saved;
+        s->fd_open += proc_shards[i].fds.nfds;
+        s->tracks_live += g_hash_table_size(proc_shards[i].track_table);
+        s->tracks_pooled += proc_shards[i].tracks.allocated;
+    }
+
+    s->scan_workers = used;
+    s->scan_us = g_get_monotonic_time() - t0;
+}
+
+/* ================= 线程扫描 ================= */
+// 只扫描线程视图正在显示的那一个进程的 /proc/PID/task，平时每轮的开销不变
+static GHashTable* thread_cpu_table;    // tid -> ProcCpu
+static int thread_table_pid = -1;
+
+// 本轮没有更新到的条目属于已退出的线程
+static gboolean thread_cpu_stale(gpointer key, gpointer value, gpointer user_data)
+{
+    return ((ProcCpu*)value)->sys_total != *(const long long*)user_data;
+}
+
+// 需要先采集 s->sys
+void collect_thread_rows(Snapshot* s, int pid)
+{
+    if (!thread_cpu_table)
+        thread_cpu_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    // 换了进程，旧的增量基准没有意义
+    if (pid != thread_table_pid) {
+        g_hash_table_remove_all(thread_cpu_table);
+        thread_table_pid = pid;
+    }
+
+    s->thread_pid = pid;
+    s->threads = g_array_new(FALSE, FALSE, sizeof(ThreadRow));
+
+    char dir_path[300];
+    snprintf(dir_path, sizeof(dir_path), "%s/%d/task", proc_root, pid);
+    DIR* dir = opendir(dir_path);
+    if (!dir) return;
+
+    long long sys_total = s->sys.cpu.total;
+    struct dirent* e;
+    while ((e = readdir(dir))) {
+        if (!is_pid_dir(e->d_name)) continue;
+        int tid = atoi(e->d_name);
+
+        char path[320];
+        char buf[1024];
+        ProcStat ps;
+        snprintf(path, sizeof(path), "%s/%d/stat", dir_path, tid);
+        if (read_file(path, buf, sizeof(buf)) <= 0 || !parse_task_stat(buf, &ps)) continue;
+
+        ThreadRow row;
+        row.tid = tid;
+        g_strlcpy(row.name, ps.name, sizeof(row.name));
+        row.state = ps.state;
+        row.last_cpu = ps.processor;
+        row.cpu = proc_cpu_delta(thread_cpu_table, tid, ps.utime, ps.stime, sys_total);
+        g_array_append_val(s->threads, row);
+    }
+    closedir(dir);
+
+    g_hash_table_foreach_remove(thread_cpu_table, thread_cpu_stale, &sys_total);
+}
+
+/* ================= cgroup 统计 ================= */
+// 遍历 cgroup v2 层级，每个组直接读 cpu.stat、memory.*、io.stat、pids.current，
+// 已退出的子进程的用量也算在组里。增量基准用进程的同一套 ProcTrack：按相对路径查找，
+// 目录的 inode（即 cgroup ID）相当于进程的 starttime，同名的组删掉重建后基准作废。
+typedef struct {
+    long long usage_usec;
+    long long user_usec;
+    long long system_usec;
+} CgroupCpuStat;
+
+static const KvField cgroup_cpu_fields[] = {
+    { "usage_usec",  offsetof(CgroupCpuStat, usage_usec) },
+    { "user_usec",   offsetof(CgroupCpuStat, user_usec) },
+    { "system_usec", offsetof(CgroupCpuStat, system_usec) },
+};
+static KvTable cgroup_cpu_table = { cgroup_cpu_fields, G_N_ELEMENTS(cgroup_cpu_fields) };
+
+typedef struct {
+    long long anon;
+    long long file;
+} CgroupMemStat;
+
+static const KvField cgroup_mem_fields[] = {
+    { "anon", offsetof(CgroupMemStat, anon) },
+    { "file", offsetof(CgroupMemStat, file) },
+};
+static KvTable cgroup_mem_table = { cgroup_mem_fields, G_N_ELEMENTS(cgroup_mem_fields) };
+
+static GHashTable* cgroup_table;    // 相对路径 -> ProcTrack
+static TrackPool cgroup_tracks;
+static guint cgroup_gen;
+
+// cgroup 页选中的组，由主线程设置；只读这一个组的 *.pressure
+static char cgroup_selected[CGROUP_PATH_MAX];
+static GMutex cgroup_sel_lock;
+
+void cgroup_set_selected(const char* path)
+{
+    g_mutex_lock(&cgroup_sel_lock);
+    g_strlcpy(cgroup_selected, path ? path : "", sizeof(cgroup_selected));
+    g_mutex_unlock(&cgroup_sel_lock);
+}
+
+typedef struct {
+    long long sys_usec;         // 系统 CPU 总时间换算成微秒，与 cpu.stat 同单位
+    gint64 time_us;
+    GArray* out;
+} CgroupCtx;
+
+// io.stat 每个设备一行："MAJ:MIN rbytes=N wbytes=N rios=N ..."，各设备相加
+void parse_cgroup_io(const char* buf, ProcIO* io)
+{
+    io->read_bytes = io->write_bytes = 0;
+    for (const char* p = buf; p && *p; p = next_line(p)) {
+        const char* word;
+        int len;
+        tok_word(&p, &word);    // 设备号
+        while ((len = tok_word(&p, &word)) > 0) {
+            const char* v = word + 7;
+            if (len > 7 && strncmp(word, "rbytes=", 7) == 0)
+                io->read_bytes += tok_num(&v);
+            else if (len > 7 && strncmp(word, "wbytes=", 7) == 0)
+                io->write_bytes += tok_num(&v);
+        }
+    }
+}
+
+// 读 dir/name 中的一个整数，文件不存在返回 -1
+static long long read_cgroup_num(char* dir, size_t dir_len, const char* name)
+{
+    char buf[64];
+    snprintf(dir + dir_len, PATH_MAX - dir_len, "/%s", name);
+    ssize_t n = read_file(dir, buf, sizeof(buf));
+    dir[dir_len] = '\0';
+    if (n <= 0) return -1;
+    const char* p = buf;
+    return tok_num(&p);
+}
+
+static int read_cgroup_file(char* dir, size_t dir_len, const char* name, char* buf, size_t size)
+{
+    snprintf(dir + dir_len, PATH_MAX - dir_len, "/%s", name);
+    ssize_t n = read_file(dir, buf, size);
+    dir[dir_len] = '\0';
+    return n > 0;
+}
+
+static void cgroup_read(CgroupCtx* ctx, char* dir, size_t dir_len, size_t root_len, ino_t ino)
+{
+    const char* rel = dir_len > root_len ? dir + root_len : "/";
+    ProcTrack* t = g_hash_table_lookup(cgroup_table, rel);
+    if (!t) {
+        t = track_pool_alloc(&cgroup_tracks);
+        g_hash_table_insert(cgroup_table, g_strdup(rel), t);
+        memset(t, 0, sizeof(*t));
+        t->starttime = ino;
+    }
+    else if (t->starttime != ino) {
+        memset(t, 0, sizeof(*t));
+        t->starttime = ino;
+    }
+    t->gen = cgroup_gen;
+
+    CgroupRow row;
+    memset(&row, 0, sizeof(row));
+    g_strlcpy(row.path, rel, sizeof(row.path));
+
+    char buf[4096];
+    CgroupCpuStat cs = { 0 };
+    if (read_cgroup_file(dir, dir_len, "cpu.stat", buf, sizeof(buf))) {
+        parse_flat_kv(buf, &cgroup_cpu_table, &cs);
+        row.cpu = proc_cpu_step(&t->cpu, cs.user_usec, cs.system_usec, ctx->sys_usec);
+    }
+
+    row.mem_bytes = MAX(read_cgroup_num(dir, dir_len, "memory.current"), 0);
+    CgroupMemStat ms = { 0 };
+    if (read_cgroup_file(dir, dir_len, "memory.stat", buf, sizeof(buf))) {
+        parse_flat_kv(buf, &cgroup_mem_table, &ms);
+        row.anon_bytes = ms.anon;
+        row.file_bytes = ms.file;
+    }
+
+    ProcIO io;
+    if (read_cgroup_file(dir, dir_len, "io.stat", buf, sizeof(buf))) {
+        parse_cgroup_io(buf, &io);
+        io.time_us = ctx->time_us;
+        proc_io_step(t, &io, &row.read_kb, &row.write_kb);
+    }
+    else {
+        t->has_io = FALSE;
+    }
+
+    row.pids = MAX(read_cgroup_num(dir, dir_len, "pids.current"), 0);
+    g_array_append_val(ctx->out, row);
+}
+
+// dir 是 PATH_MAX 大小的缓冲区，递归时在末尾追加子目录名，返回前恢复
+static void cgroup_walk(CgroupCtx* ctx, char* dir, size_t dir_len, size_t root_len, ino_t ino)
+{
+    cgroup_read(ctx, dir, dir_len, root_len, ino);
+
+    DIR* d = opendir(dir);
+    if (!d) return;
+    struct dirent* e;
+    while ((e = readdir(d))) {
+        if (e->d_name[0] == '.') continue;
+        size_t len = strlen(e->d_name);
+        if (dir_len + 1 + len >= PATH_MAX) continue;
+
+        dir[dir_len] = '/';
+        memcpy(dir + dir_len + 1, e->d_name, len + 1);
+        struct stat st;
+        if ((e->d_type == DT_DIR || e->d_type == DT_UNKNOWN) && stat(dir, &st) == 0 && S_ISDIR(st.st_mode))
+            cgroup_walk(ctx, dir, dir_len + 1 + len, root_len, st.st_ino);
+        dir[dir_len] = '\0';
+    }
+    closedir(d);
+}
+
+// 需要先采集 s->sys；不是 cgroup v2 时得到空数组
+void collect_cgroups(Snapshot* s)
+{
+    if (!cgroup_table) {
+        cgroup_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+        cgroup_tracks.blocks = g_ptr_array_new_with_free_func(g_free);
+    }
+    s->cgroups = g_array_new(FALSE, FALSE, sizeof(CgroupRow));
+    cgroup_gen++;
+
+    char dir[PATH_MAX];
+    struct stat st;
+    sys_path(dir, sizeof(dir), "fs/cgroup/cgroup.controllers");
+    if (stat(dir, &st) != 0) return;
+    sys_path(dir, sizeof(dir), "fs/cgroup");
+    if (stat(dir, &st) != 0) return;
+
+    CgroupCtx ctx;
+    ctx.sys_usec = s->sys.cpu.total * (G_USEC_PER_SEC / sysconf(_SC_CLK_TCK));
+    ctx.time_us = s->time_us;
+    ctx.out = s->cgroups;
+    size_t root_len = strlen(dir);
+    cgroup_walk(&ctx, dir, root_len, root_len, st.st_ino);
+
+    track_table_sweep(cgroup_table, &cgroup_tracks, cgroup_gen);
+
+    g_mutex_lock(&cgroup_sel_lock);
+    g_strlcpy(s->cgroup_psi_path, cgroup_selected, sizeof(s->cgroup_psi_path));
+    g_mutex_unlock(&cgroup_sel_lock);
+    if (s->cgroup_psi_path[0]) {
+        for (int i = 0; i < PSI_RES; i++) {
+            snprintf(dir + root_len, sizeof(dir) - root_len, "%s/%s",
+                strcmp(s->cgroup_psi_path, "/") == 0 ? "" : s->cgroup_psi_path, psi_cgroup_names[i]);
+            get_psi(dir, &s->cgroup_psi[i]);
+        }
+        dir[root_len] = '\0';
+    }
+}
+
+// 计数变小说明接口被重建，这一轮记 0
+static inline double counter_rate(unsigned long long cur, unsigned long long prev, double secs)
+{
+    return cur >= prev ? (cur - prev) / secs : 0.0;
+}
+
+// 按名字对上一轮的计数，热插拔后下标变化也不会错配。
+// 合计覆盖全部 n_cur 个设备，快照只保留前 sys->n_disks 个的明细
+static void disk_rates(SystemSnapshot* sys, const DiskCounters* cur, int n_cur,
+                       const DiskCounters* prev, int n_prev, double secs)
+{
+    DiskRate* t = &sys->disk_total;
+    double rd_ms = 0, wr_ms = 0;
+
+    for (int i = 0; i < n_cur; i++) {
+        const DiskCounters* c = &cur[i];
+        const DiskCounters* p = NULL;
+        if (i < n_prev && strcmp(prev[i].name, c->name) == 0)
+            p = &prev[i];
+        for (int j = 0; !p && j < n_prev; j++)
+            if (strcmp(prev[j].name, c->name) == 0) p = &prev[j];
+        if (!p) continue;
+
+        DiskRate extra = { .in_flight = c->in_flight };
+        DiskRate* r = i < sys->n_disks ? &sys->disks[i] : &extra;
+        double rd_ios = counter_rate(c->rd_ios, p->rd_ios, 1.0);
+        double wr_ios = counter_rate(c->wr_ios, p->wr_ios, 1.0);
+        r->read_iops = rd_ios / secs;
+        r->write_iops = wr_ios / secs;
+        r->read_kb = counter_rate(c->rd_sectors, p->rd_sectors, secs) * 512.0 / 1024.0;
+        r->write_kb = counter_rate(c->wr_sectors, p->wr_sectors, secs) * 512.0 / 1024.0;
+        // 读写各自的耗时毫秒数除以完成的请求数
+        if (rd_ios > 0) r->read_lat_ms = counter_rate(c->rd_ms, p->rd_ms, 1.0) / rd_ios;
+        if (wr_ios > 0) r->write_lat_ms = counter_rate(c->wr_ms, p->wr_ms, 1.0) / wr_ios;
+        // io_ticks 单位是毫秒，除以经过的毫秒数得到百分比
+        r->busy = MIN(counter_rate(c->io_ticks, p->io_ticks, secs) / 10.0, 100.0);
+
+        if (c->stacked) continue;
+        t->read_iops += r->read_iops;
+        t->write_iops += r->write_iops;
+        t->read_kb += r->read_kb;
+        t->write_kb += r->write_kb;
+        t->in_flight += r->in_flight;
+        t->busy = MAX(t->busy, r->busy);
+        rd_ms += r->read_lat_ms * rd_ios;
+        wr_ms += r->write_lat_ms * wr_ios;
+    }
+    if (t->read_iops > 0) t->read_lat_ms = rd_ms / (t->read_iops * secs);
+    if (t->write_iops > 0) t->write_lat_ms = wr_ms / (t->write_iops * secs);
+    sys->disk_kb = t->read_kb + t->write_kb;
+}
+
+// 按名字对上一轮的计数，接口增删或顺序变化时依然正确
+static void net_rates(SystemSnapshot* sys, const NetDevCounters* cur, const NetDevCounters* prev, int n_prev, double secs)
+{
+    for (int i = 0; i < sys->n_net; i++) {
+        const NetDevCounters* c = &cur[i];
+        const NetDevCounters* p = NULL;
+        if (i < n_prev && strcmp(prev[i].name, c->name) == 0)
+            p = &prev[i];
+        for (int j = 0; !p && j < n_prev; j++)
+            if (strcmp(prev[j].name, c->name) == 0) p = &prev[j];
+
+        NetRate* r = &sys->net[i];
+        r->errs = c->rx_errs + c->tx_errs;
+        r->drops = c->rx_drop + c->tx_drop;
+        if (!p) continue;
+
+        r->rx_kb = counter_rate(c->rx_bytes, p->rx_bytes, secs) / 1024.0;
+        r->tx_kb = counter_rate(c->tx_bytes, p->tx_bytes, secs) / 1024.0;
+        r->rx_pps = counter_rate(c->rx_packets, p->rx_packets, secs);
+        r->tx_pps = counter_rate(c->tx_packets, p->tx_packets, secs);
+        r->errs_ps = counter_rate(r->errs, p->rx_errs + p->tx_errs, secs);
+        r->drop_ps = counter_rate(r->drops, p->rx_drop + p->tx_drop, secs);
+
+        // 回环流量不离开本机，不计入合计
+        if (strcmp(c->name, "lo") != 0) {
+            sys->net_rx_kb += r->rx_kb;
+            sys->net_tx_kb += r->tx_kb;
+        }
+    }
+}
+
+void collect_system(SystemSnapshot* sys)
+{
+    static SystemSnapshot prev;
+    static int have_prev = 0;
+    // 每核计数两份轮流使用，差值用的暂存区跟着核数增长，平时不分配
+    static CoreCounters cores[2];
+    static int cur_cores = 0;
+    static long long* busy_tmp = NULL;
+    static long long* total_tmp = NULL;
+    static int tmp_cap = 0;
+    // 网络、磁盘计数同样两份轮流使用
+    static NetDevCounters net_dev[2][NET_MAX_IFACES];
+    static int net_n[2];
+    static int cur_ctr = 0;
+    static DiskCounters* disk_ctr[2];
+    static int disk_cap[2];
+    static int disk_n[2];
+
+    CoreCounters* cc = &cores[cur_cores];
+    CoreCounters* pc = &cores[cur_cores ^ 1];
+    NetDevCounters* nc = net_dev[cur_ctr];
+    const NetDevCounters* np = net_dev[cur_ctr ^ 1];
+    sys->time_us = g_get_monotonic_time();
+    get_cpu_stat(&sys->cpu, cc);
+    sys->mem_ok = get_mem_stat(&sys->mem);
+    disk_n[cur_ctr] = get_disk_stats(&disk_ctr[cur_ctr], &disk_cap[cur_ctr]);
+    DiskCounters* dc = disk_ctr[cur_ctr];
+    const DiskCounters* dp = disk_ctr[cur_ctr ^ 1];
+    sys->disk_ok = disk_n[cur_ctr] >= 0;
+    sys->n_disks = CLAMP(disk_n[cur_ctr], 0, DISK_MAX_DEVS);
+    for (int i = 0; i < sys->n_disks; i++) {
+        memcpy(sys->disks[i].name, dc[i].name, DISK_NAME_MAX);
+        sys->disks[i].stacked = dc[i].stacked;
+        sys->disks[i].in_flight = dc[i].in_flight;
+    }
+    sys->mem_p = get_mem_percent(&sys->mem);
+    for (int i = 0; i < PSI_RES; i++) {
+        char path[300];
+        get_psi(proc_path(path, sizeof(path), psi_proc_names[i]), &sys->psi[i]);
+    }
+    net_n[cur_ctr] = get_net_dev(nc, NET_MAX_IFACES);
+    sys->n_net = net_n[cur_ctr];
+    for (int i = 0; i < sys->n_net; i++)
+        memcpy(sys->net[i].name, nc[i].name, NET_NAME_MAX);
+    sys->tcp_ok = get_tcp_stat(&sys->tcp);
+
+    if (have_prev) {
+        sys->elapsed_s = (sys->time_us - prev.time_us) / (double)G_USEC_PER_SEC;
+        sys->cpu_total_diff = sys->cpu.total - prev.cpu.total;
+        long long idle_diff = sys->cpu.idle - prev.cpu.idle;
+        if (sys->cpu_total_diff > 0) {
+            sys->cpu_p = 100.0 * (1.0 - (double)idle_diff / sys->cpu_total_diff);
+            for (int i = 0; i < CPU_FIELDS; i++)
+                sys->cpu_split[i] = 100.0 * (sys->cpu.f[i] - prev.cpu.f[i]) / sys->cpu_total_diff;
+        }
+
+        if (cc->n > 0) {
+            if (cc->n > tmp_cap) {
+                tmp_cap = cc->cap;
+                busy_tmp = g_renew(long long, busy_tmp, tmp_cap);
+                total_tmp = g_renew(long long, total_tmp, tmp_cap);
+            }
+            sys->n_cores = cc->n;
+            sys->core_usage = core_usage_take(cc->cap, &sys->core_usage_cap);
+            core_usage_delta(cc, pc, sys->core_usage, busy_tmp, total_tmp);
+        }
+    }
+
+    // 速率按实际经过的时间计算，采样迟到或间隔不足 1 秒时依然准确
+    if (have_prev && sys->elapsed_s > 0) {
+        double secs = sys->elapsed_s;
+        disk_rates(sys, dc, MAX(disk_n[cur_ctr], 0), dp, disk_n[cur_ctr ^ 1], secs);
+        // PSI 的 total 单位是微秒，同样按实际间隔换算成百分比
+        for (int i = 0; i < PSI_RES; i++) {
+            if (!sys->psi[i].ok || !prev.psi[i].ok) continue;
+            sys->psi_some_p[i] = (sys->psi[i].some.total - prev.psi[i].some.total) / (secs * 10000.0);
+            sys->psi_full_p[i] = (sys->psi[i].full.total - prev.psi[i].full.total) / (secs * 10000.0);
+        }
+        net_rates(sys, nc, np, net_n[cur_ctr ^ 1], secs);
+        if (sys->tcp_ok && prev.tcp_ok) {
+            long long out = sys->tcp.out_segs - prev.tcp.out_segs;
+            long long retrans = sys->tcp.retrans_segs - prev.tcp.retrans_segs;
+            if (retrans > 0) {
+                sys->tcp_retrans_ps = retrans / secs;
+                if (out > 0) sys->tcp_retrans_p = 100.0 * retrans / out;
+            }
+        }
+    }
+
+    // prev 只用来算计数差值，不会访问其中的 core_usage
+    prev = *sys;
+    have_prev = sys->cpu.total > 0;
+    cur_cores ^= 1;
+    cur_ctr ^= 1;
+}
+
+// what 为 COLLECT_* 的组合；系统计数每轮都读，保证历史曲线和差值连续
+Snapshot* collect_snapshot_with(int what)
+{
+    static CpuInfo last_info;
+    Snapshot* s = g_new0(Snapshot, 1);
+
+    s->wall_us = g_get_real_time();
+    s->seq = -1;
+    collect_system(&s->sys);
+    s->time_us = s->sys.time_us;
+    if (what & COLLECT_PROCS) {
+        collect_process_rows(s);
+        int tpid = g_atomic_int_get(&thread_pid);
+        if (tpid > 0)
+            collect_thread_rows(s, tpid);
+    }
+    if (what & COLLECT_CGROUPS)
+        collect_cgroups(s);
+
+    // /proc/cpuinfo 在多核机器上很长，CPU 页不可见时沿用上次的结果
+    if ((what & COLLECT_CPU_INFO) || last_info.model[0] == '\0')
+        get_cpu_info(&last_info);
+    s->cpu_info = last_info;
+
+    return s;
+}
+
+Snapshot* collect_snapshot()
+{
+    return collect_snapshot_with(COLLECT_ALL);
+}
+
+void snapshot_free(Snapshot* s)
+{
+    if (!s) return;
+    if (s->procs) g_array_free(s->procs, TRUE);
+    if (s->keys) g_string_free(s->keys, TRUE);
+    if (s->threads) g_array_free(s->threads, TRUE);
+    if (s->cgroups) g_array_free(s->cgroups, TRUE);
+    core_usage_give(s->sys.core_usage, s->sys.core_usage_cap);
+    g_free(s);
+}
+
+/* ================= 进程列表更新 ================= */
+void update_process_list(const Snapshot* s)
+{
+    // 进程列表不可见时本轮没有扫描，保留原有行
+    if (!s->procs) return;
+
+    // 保存选中的 PID
+    if (is_selection)
+    {
+        GtkTreeSelection* selection = gtk_tree_view_get_selection(GTK_TREE_VIEW(process_tree_view));
+        GtkTreeModel* model;
+        GtkTreeIter iter;
+        if (gtk_tree_selection_get_selected(selection, &model, &iter))
+        {
+            gtk_tree_model_get(model, &iter, COL_PID, &selected_pid, -1);
+        }
+    }
+
+    // 整体替换模型数据，TreeView 重绘时只读取屏幕上的行
+    process_view_refresh(proc_model_set_rows(proc_model, s));
+
+    // ---- 恢复之前选中的行 ----
+    process_view_reselect();
+}
+
+// 按 TID 原地更新，和 cgroup 列表一样，选中行和滚动位置不受影响
+void update_thread_list(const Snapshot* s)
+{
+    // 没有选中进程或线程视图收起时清空；选中了但本轮没扫描时保留原有行
+    if (!s->threads) {
+        if (g_atomic_int_get(&thread_pid) <= 0) {
+            gtk_list_store_clear(thread_store);
+            gtk_expander_set_label(GTK_EXPANDER(thread_expander), "线程");
+        }
+        return;
+    }
+
+    GHashTable* rows = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (guint i = 0; i < s->threads->len; i++) {
+        ThreadRow* t = &g_array_index(s->threads, ThreadRow, i);
+        g_hash_table_insert(rows, GINT_TO_POINTER(t->tid), t);
+    }
+
+    GtkTreeSortable* sortable = GTK_TREE_SORTABLE(thread_store);
+    gint sort_col;
+    GtkSortType sort_order;
+    gboolean sorted = gtk_tree_sortable_get_sort_column_id(sortable, &sort_col, &sort_order);
+    gtk_tree_sortable_set_sort_column_id(sortable, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+
+    GtkTreeModel* model = GTK_TREE_MODEL(thread_store);
+    GtkTreeIter iter;
+    gboolean valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        int tid;
+        gtk_tree_model_get(model, &iter, TCOL_TID, &tid, -1);
+        const ThreadRow* t = g_hash_table_lookup(rows, GINT_TO_POINTER(tid));
+        if (!t) {
+            valid = gtk_list_store_remove(thread_store, &iter);
+            continue;
+        }
+        char state[2] = { t->state, '\0' };
+        gtk_list_store_set(thread_store, &iter,
+            TCOL_NAME, t->name,
+            TCOL_STATE, state,
+            TCOL_LAST_CPU, t->last_cpu,
+            TCOL_CPU, t->cpu,
+            -1);
+        g_hash_table_remove(rows, GINT_TO_POINTER(tid));
+        valid = gtk_tree_model_iter_next(model, &iter);
+    }
+
+    // 剩下的是新出现的线程
+    GHashTableIter hi;
+    gpointer value;
+    g_hash_table_iter_init(&hi, rows);
+    while (g_hash_table_iter_next(&hi, NULL, &value)) {
+        const ThreadRow* t = value;
+        char state[2] = { t->state, '\0' };
+        gtk_list_store_insert_with_values(thread_store, NULL, -1,
+            TCOL_TID, t->tid,
+            TCOL_NAME, t->name,
+            TCOL_STATE, state,
+            TCOL_LAST_CPU, t->last_cpu,
+            TCOL_CPU, t->cpu,
+            -1);
+    }
+    g_hash_table_destroy(rows);
+
+    if (sorted)
+        gtk_tree_sortable_set_sort_column_id(sortable, sort_col, sort_order);
+
+    char title[64];
+    snprintf(title, sizeof(title), "线程（PID %d，%u 个）", s->thread_pid, s->threads->len);
+    gtk_expander_set_label(GTK_EXPANDER(thread_expander), title);
+}
+
+// 按路径原地更新，选中行和滚动位置不受影响；更新期间关掉排序，最后只排一次
+void update_cgroup_list(const Snapshot* s)
+{
+    if (!s->cgroups) return;
+
+    GHashTable* rows = g_hash_table_new(g_str_hash, g_str_equal);
+    for (guint i = 0; i < s->cgroups->len; i++) {
+        CgroupRow* r = &g_array_index(s->cgroups, CgroupRow, i);
+        g_hash_table_insert(rows, r->path, r);
+    }
+
+    GtkTreeSortable* sortable = GTK_TREE_SORTABLE(cgroup_store);
+    gint sort_col;
+    GtkSortType sort_order;
+    gboolean sorted = gtk_tree_sortable_get_sort_column_id(sortable, &sort_col, &sort_order);
+    gtk_tree_sortable_set_sort_column_id(sortable, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+
+    GtkTreeModel* model = GTK_TREE_MODEL(cgroup_store);
+    GtkTreeIter iter;
+    gboolean valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        char* path;
+        gtk_tree_model_get(model, &iter, CGCOL_PATH, &path, -1);
+        const CgroupRow* r = g_hash_table_lookup(rows, path);
+        g_free(path);
+        if (!r) {
+            valid = gtk_list_store_remove(cgroup_store, &iter);
+            continue;
+        }
+        gtk_list_store_set(cgroup_store, &iter,
+            CGCOL_CPU, r->cpu,
+            CGCOL_MEM, r->mem_bytes / 1048576.0,
+            CGCOL_ANON, r->anon_bytes / 1048576.0,
+            CGCOL_FILE, r->file_bytes / 1048576.0,
+            CGCOL_READ, r->read_kb,
+            CGCOL_WRITE, r->write_kb,
+            CGCOL_PIDS, (int)r->pids,
+            -1);
+        g_hash_table_remove(rows, r->path);
+        valid = gtk_tree_model_iter_next(model, &iter);
+    }
+
+    // 剩下的是新出现的组
+    GHashTableIter hi;
+    gpointer value;
+    g_hash_table_iter_init(&hi, rows);
+    while (g_hash_table_iter_next(&hi, NULL, &value)) {
+        const CgroupRow* r = value;
+        gtk_list_store_insert_with_values(cgroup_store, NULL, -1,
+            CGCOL_PATH, r->path,
+            CGCOL_CPU, r->cpu,
+            CGCOL_MEM, r->mem_bytes / 1048576.0,
+            CGCOL_ANON, r->anon_bytes / 1048576.0,
+            CGCOL_FILE, r->file_bytes / 1048576.0,
+            CGCOL_READ, r->read_kb,
+            CGCOL_WRITE, r->write_kb,
+            CGCOL_PIDS, (int)r->pids,
+            -1);
+    }
+    g_hash_table_destroy(rows);
+
+    if (sorted)
+        gtk_tree_sortable_set_sort_column_id(sortable, sort_col, sort_order);
+
+    char buf[128];
+    if (s->cgroups->len == 0)
+        snprintf(buf, sizeof(buf), "未找到 cgroup v2 层级（%s/fs/cgroup）", sys_root);
+    else
+        snprintf(buf, sizeof(buf), "%u 个 cgroup，双击在进程页中查看组内进程", s->cgroups->len);
+    gtk_label_set_text(GTK_LABEL(cgroup_label), buf);
+
+    if (!s->cgroup_psi_path[0]) {
+        gtk_label_set_text(GTK_LABEL(cgroup_psi_label), "选中一个 cgroup 查看它的压力信息");
+        return;
+    }
+    GString* text = g_string_new(NULL);
+    g_string_append_printf(text, "%s 的压力（avg10 / avg60 / avg300）", s->cgroup_psi_path);
+    for (int i = 0; i < PSI_RES; i++) {
+        char line[160];
+        if (s->cgroup_psi[i].ok)
+            format_psi(line, sizeof(line), psi_titles[i], &s->cgroup_psi[i]);
+        else
+            snprintf(line, sizeof(line), "%s  不可用", psi_titles[i]);
+        g_string_append_printf(text, "\n%s", line);
+    }
+    gtk_label_set_text(GTK_LABEL(cgroup_psi_label), text->str);
+    g_string_free(text, TRUE);
+}
+
+/* ================= 系统状态刷新 ================= */
+void update_system_summary(const Snapshot* s)
+{
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+        "System Total | CPU: %.1f%% | MEM: %.1f%% | Disk: %.1f KB/s",
+        s->sys.cpu_p, s->sys.mem_p, s->sys.disk_kb);
+
+    gtk_label_set_text(GTK_LABEL(sys_label), buf);
+}
+
+void update_system_total(const Snapshot* s)
+{
+    cpu_p = s->sys.cpu_p;
+    mem_p = s->sys.mem_p;
+    disk_kb = s->sys.disk_kb;
+
+    /* 更新历史数据 */
+    if (s->discontinuous)
+        perf_history_reset(&perf_history);
+    metric_history_add(&perf_history.cpu, cpu_p, s->time_us);
+    metric_history_add(&perf_history.mem, mem_p, s->time_us);
+    metric_history_add(&perf_history.disk, disk_kb, s->time_us);
+    for (int i = 0; i < PSI_RES; i++)
+        metric_history_add(&perf_history.psi[i], s->sys.psi_some_p[i], s->time_us);
+    metric_history_add(&perf_history.net, s->sys.net_rx_kb + s->sys.net_tx_kb, s->time_us);
+    if (disk_history_add(&perf_history, &s->sys, s->time_us) > 0 && history_mem_label) {
+        char mem[64];
+        snprintf(mem, sizeof(mem), "历史数据占用 %.1f MB", perf_history_bytes() / 1024.0 / 1024.0);
+        gtk_label_set_text(GTK_LABEL(history_mem_label), mem);
+    }
+
+    /* 更新性能面板标签 */
+    char buf[64];
+
+    //snprintf(buf, sizeof(buf), "CPU %.1f%% %.2f GHz", cpu_p, 1.4);
+    //gtk_label_set_text(GTK_LABEL(perf_cpu_label), buf);
+
+    snprintf(buf, sizeof(buf), "内存 %.1f%% %.1f GB", mem_p, 16.5);
+    gtk_label_set_text(GTK_LABEL(perf_mem_label), buf);
+
+    snprintf(buf, sizeof(buf), "磁盘 %.1f KB/s", disk_kb);
+    gtk_label_set_text(GTK_LABEL(perf_disk_label), buf);
+
+    if (s->sys.elapsed_s > 0) {
+        snprintf(buf, sizeof(buf), "采样间隔 %.0f ms | 抖动 p99 %.2f ms",
+            s->sys.elapsed_s * 1000.0, s->jitter_p99_us / 1000.0);
+        gtk_label_set_text(GTK_LABEL(sample_jitter_label), buf);
+    }
+
+    // 隐藏的 stack 子页面没有映射，不会排队重画
+    perf_queue_draw(cpu_drawing_area);
+    perf_queue_draw(mem_drawing_area);
+    perf_queue_draw(disk_drawing_area);
+    for (int i = 0; i < PSI_RES; i++)
+        perf_queue_draw(psi_drawing_area[i]);
+    perf_queue_draw(net_drawing_area);
+}
+
+void update_cpu_detail_label(const Snapshot* s)
+{
+    const CpuInfo* info = &s->cpu_info;
+
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+        "型号: %s | 核心: %d | 线程: %d | 缓存: %d KB | 当前频率: %.2f GHz | 使用率: %.1f%%",
+        info->model, info->cores, info->threads, info->cache_kb, info->freq_ghz,
+        cpu_p);
+
+    gtk_label_set_text(GTK_LABEL(cpu_detail_label), buf);
+}
+
+void update_cpu_cores(const Snapshot* s)
+{
+    if (s->discontinuous) core_history_reset();
+    if (s->sys.n_cores > 0)
+        core_history_add(s->sys.core_usage, s->sys.n_cores);
+
+    const double* f = s->sys.cpu_split;
+    char buf[160];
+    snprintf(buf, sizeof(buf), "用户: %.1f%% | 系统: %.1f%% | IO 等待: %.1f%% | 中断: %.1f%% | 窃取: %.1f%%",
+        f[CPU_USER] + f[CPU_NICE], f[CPU_SYSTEM], f[CPU_IOWAIT], f[CPU_IRQ] + f[CPU_SOFTIRQ], f[CPU_STEAL]);
+    gtk_label_set_text(GTK_LABEL(cpu_split_label), buf);
+
+    perf_queue_draw(cpu_core_area);
+}
+
+void update_memory_info(const Snapshot* s)
+{
+    if (!s->sys.mem_ok) return;
+    const MemStat* m = &s->sys.mem;
+
+    // 转 GB
+    double mem_total_gb = m->mem_total / 1024.0 / 1024.0;
+    double mem_free_gb = m->mem_free / 1024.0 / 1024.0;
+    double buffers_gb = m->buffers / 1024.0 / 1024.0;
+    double cached_gb = m->cached / 1024.0 / 1024.0;
+    double swap_total_gb = m->swap_total / 1024.0 / 1024.0;
+    double swap_free_gb = m->swap_free / 1024.0 / 1024.0;
+
+    double mem_used_gb = mem_total_gb - mem_free_gb - buffers_gb - cached_gb;
+    double mem_available_gb = mem_free_gb + buffers_gb + cached_gb;
+    double swap_used_gb = swap_total_gb - swap_free_gb;
+
+    double mem_used_percent = (mem_used_gb / mem_total_gb) * 100.0;
+    double swap_used_percent = (swap_total_gb > 0) ? (swap_used_gb / swap_total_gb * 100.0) : 0.0;
+
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+        "内存总量:  %.2f GB\n"
+        "已用内存:  %.2f GB (%.1f%%)\n"
+        "可用内存:  %.2f GB\n"
+        "缓冲区+缓存: %.2f GB\n"
+        "交换总量:  %.2f GB\n"
+        "已用交换:  %.2f GB (%.1f%%)",
+        mem_total_gb,
+        mem_used_gb, mem_used_percent,
+        mem_available_gb,
+        buffers_gb + cached_gb,
+        swap_total_gb,
+        swap_used_gb, swap_used_percent
+    );
+
+    // 安全检查，确保 mem_info_label 是 GtkLabel
+    if (GTK_IS_LABEL(mem_info_label))
+        gtk_label_set_text(GTK_LABEL(mem_info_label), buf);
+}
+
+
+// 磁盘图显示的历史换了（切换设备、设备第一次有历史）时整图重画
+static void disk_graph_sync()
+{
+    static const MetricHistory* shown;
+    const MetricHistory* h = graph_metric(PERF_DISK);
+    if (h == shown) return;
+    shown = h;
+    graph_cache[PERF_DISK].epoch = perf_history.epoch - 1;
+    perf_queue_draw(disk_drawing_area);
+}
+
+// 下拉框第 0 项是全部磁盘，之后依次是 disk_names
+static char disk_names[DISK_MAX_DEVS][DISK_NAME_MAX];
+static int n_disk_names = 0;
+static int disk_combo_updating = 0;
+
+void on_disk_device_changed(GtkComboBox* combo, gpointer user_data)
+{
+    if (disk_combo_updating) return;
+    int i = gtk_combo_box_get_active(combo);
+    if (i > 0 && i <= n_disk_names)
+        memcpy(disk_selected, disk_names[i - 1], DISK_NAME_MAX);
+    else
+        disk_selected[0] = '\0';
+    disk_graph_sync();
+}
+
+// 设备列表变化时重建下拉框，尽量保持原来的选择
+static void disk_combo_sync(const SystemSnapshot* sys)
+{
+    int same = sys->n_disks == n_disk_names;
+    for (int i = 0; same && i < n_disk_names; i++)
+        same = strcmp(disk_names[i], sys->disks[i].name) == 0;
+    if (same) return;
+
+    disk_combo_updating = 1;
+    gtk_combo_box_text_remove_all(GTK_COMBO_BOX_TEXT(disk_combo));
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(disk_combo), "全部磁盘");
+    int active = 0;
+    n_disk_names = sys->n_disks;
+    for (int i = 0; i < n_disk_names; i++) {
+        const DiskRate* r = &sys->disks[i];
+        char text[64];
+        snprintf(text, sizeof(text), r->stacked ? "%s（虚拟）" : "%s", r->name);
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(disk_combo), text);
+        memcpy(disk_names[i], r->name, DISK_NAME_MAX);
+        if (strcmp(r->name, disk_selected) == 0) active = i + 1;
+    }
+    if (active == 0) disk_selected[0] = '\0';
+    gtk_combo_box_set_active(GTK_COMBO_BOX(disk_combo), active);
+    disk_combo_updating = 0;
+}
+
+void update_disk_info(const Snapshot* s)
+{
+    if (!s->sys.disk_ok) return;
+
+    // 回放的录制文件里只有合计，下拉框只剩"全部磁盘"
+    disk_combo_sync(&s->sys);
+    disk_graph_sync();
+
+    const DiskRate* r = &s->sys.disk_total;
+    for (int i = 0; disk_selected[0] && i < s->sys.n_disks; i++)
+        if (strcmp(s->sys.disks[i].name, disk_selected) == 0) r = &s->sys.disks[i];
+
+    char buf[160];
+    snprintf(buf, sizeof(buf), "读取: %.1f KB/s | %.0f IOPS | 平均延迟 %.2f ms",
+        r->read_kb, r->read_iops, r->read_lat_ms);
+    gtk_label_set_text(GTK_LABEL(disk_read_label), buf);
+
+    snprintf(buf, sizeof(buf), "写入: %.1f KB/s | %.0f IOPS | 平均延迟 %.2f ms",
+        r->write_kb, r->write_iops, r->write_lat_ms);
+    gtk_label_set_text(GTK_LABEL(disk_write_label), buf);
+
+    snprintf(buf, sizeof(buf), "活动时间: %.1f %% | 队列中的请求: %.0f", r->busy, r->in_flight);
+    gtk_label_set_text(GTK_LABEL(disk_active_label), buf);
+}
+
+void update_psi_info(const Snapshot* s)
+{
+    char buf[192];
+    if (!s->sys.psi[PSI_CPU].ok) {
+        gtk_label_set_text(GTK_LABEL(perf_psi_label), "内核未提供 /proc/pressure（需要 CONFIG_PSI）");
+        return;
+    }
+
+    snprintf(buf, sizeof(buf), "本轮停顿 CPU %.1f%% | 内存 %.1f%% | I/O %.1f%%",
+        s->sys.psi_some_p[PSI_CPU], s->sys.psi_some_p[PSI_MEM], s->sys.psi_some_p[PSI_IO]);
+    gtk_label_set_text(GTK_LABEL(perf_psi_label), buf);
+
+    for (int i = 0; i < PSI_RES; i++) {
+        char line[160];
+        format_psi(line, sizeof(line), psi_titles[i], &s->sys.psi[i]);
+        snprintf(buf, sizeof(buf), "%s  （avg10 / avg60 / avg300，本轮 full %.1f%%）", line, s->sys.psi_full_p[i]);
+        gtk_label_set_text(GTK_LABEL(psi_info_label[i]), buf);
+    }
+}
+
+void update_net_info(const Snapshot* s)
+{
+    const SystemSnapshot* sys = &s->sys;
+    char buf[256];
+
+    if (s->discontinuous) net_spark_reset();
+    int old_n = net_shown_n;
+    net_spark_add(sys);
+
+    snprintf(buf, sizeof(buf), "接收 %.1f KB/s | 发送 %.1f KB/s", sys->net_rx_kb, sys->net_tx_kb);
+    gtk_label_set_text(GTK_LABEL(perf_net_label), buf);
+
+    if (sys->tcp_ok) {
+        snprintf(buf, sizeof(buf),
+            "TCP 已建立连接: %lld | 重传: %.1f 段/s (%.2f%%) | 主动打开: %lld | 被动打开: %lld | 接收错误: %lld",
+            sys->tcp.curr_estab, sys->tcp_retrans_ps, sys->tcp_retrans_p,
+            sys->tcp.active_opens, sys->tcp.passive_opens, sys->tcp.in_errs);
+        gtk_label_set_text(GTK_LABEL(net_tcp_label), buf);
+    }
+    else {
+        gtk_label_set_text(GTK_LABEL(net_tcp_label), "TCP: 无法读取 /proc/net/snmp");
+    }
+
+    // 接口数变化时才调整高度，避免每轮重新布局
+    if (net_shown_n != old_n)
+        gtk_widget_set_size_request(net_iface_area, -1, MAX(net_shown_n, 1) * NET_ROW_H);
+    perf_queue_draw(net_iface_area);
+}
+
+/* ================= 录制文件 ================= */
+// 每轮快照追加到 mmap 的段文件里，监视器崩溃后数据仍留在页缓存/磁盘上。
+// 段文件布局：| 头部 4K | 记录索引 | 字符串表 | 数据区 |，大小在创建时预分配，
+// 写满后切换到后台线程提前准备好的下一段；msync 也由后台线程定期执行，不阻塞采集。
+#define REC_MAGIC "MOONREC1"
+#define REC_VERSION 1
+#define REC_HEADER_SIZE 4096
+#define REC_SEALED 1            // 段已写满，不会再追加
+
+typedef struct {
+    char magic[8];
+    guint32 version;
+    guint32 header_size;
+    guint64 segment_size;
+    guint32 segment_seq;
+    guint32 flags;
+    gint64 created_wall_us;
+
+    char cpu_model[128];
+    gint32 cpu_cores;
+    gint32 cpu_threads;
+
+    guint64 index_off;
+    guint64 index_cap;          // 索引项个数上限
+    guint64 strtab_off;
+    guint64 strtab_cap;
+    guint64 data_off;
+    guint64 data_cap;
+
+    // 以下三个计数在一条记录完整写入后才更新，读取时只信任它们
+    guint64 n_records;
+    guint64 strtab_used;
+    guint64 data_used;
+} RecHeader;
+
+// 每轮一项，指向数据区里的 RecSystem + RecProc[n_procs]
+typedef struct {
+    gint64 time_us;             // 单调时钟
+    gint64 wall_us;             // 墙上时间
+    guint64 data_off;           // 相对数据区起点
+    guint32 data_len;
+    guint32 n_procs;
+} RecIndex;
+
+typedef struct {
+    double cpu_p;
+    double mem_p;
+    double disk_kb;
+    double disk_read_kb;        // 读写速率和活动时间取所有磁盘的合计
+    double disk_write_kb;
+    double disk_busy;
+    double freq_ghz;
+    MemStat mem;
+} RecSystem;
+
+typedef struct {
+    gint32 pid;
+    guint32 name_off;           // 字符串表中以 '\0' 结尾的进程名
+    float cpu;
+    float mem;
+    float io_kb;
+} RecProc;
+
+typedef struct RecSegment {
+    int fd;
+    guint32 seq;
+    char* map;
+    size_t size;
+    RecHeader* hdr;
+    GHashTable* names;          // 进程名 -> 字符串表偏移 + 1，只在本段内有效
+    struct RecSegment* next;    // 待回收链表
+} RecSegment;
+
+typedef struct {
+    char* path;                 // 段文件为 path.000000、path.000001 ...
+    size_t segment_size;
+    int keep;                   // 磁盘上最多保留的段数（含当前段和预分配的下一段），0 表示不删除
+    int sync_secs;
+    guint32 prune_seq;          // 下一个要删除的段号，只由后台线程读写
+
+    RecSegment* cur;            // 只由采集线程读写
+    guint32 next_seq;           // 下一个要创建的段号
+
+    GMutex lock;                // 保护下面几项和 next_seq
+    GCond wake;
+    int preparing;              // 后台线程正在创建 spare
+    RecSegment* spare;          // 预先分配好的下一段
+    RecSegment* retired;        // 已写满、等待 msync 和 munmap 的段
+    RecSegment* active;         // 供后台线程 msync 的当前段
+} Recorder;
+
+static Recorder* recorder = NULL;
+static gchar* opt_record = NULL;
+static int record_size_mb = 64;
+static int record_keep = 0;
+static int record_sync_secs = 5;
+
+static char* rec_segment_path(const Recorder* r, guint32 seq)
+{
+    return g_strdup_printf("%s.%06u", r->path, seq);
+}
+
+static RecSegment* rec_segment_create(Recorder* r, guint32 seq)
+{
+    char* path = rec_segment_path(r, seq);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        g_printerr("无法创建录制文件 %s: %s\n", path, strerror(errno));
+        g_free(path);
+        return NULL;
+    }
+
+    // 一次分配好整个段，追加时不会因为扩展文件而阻塞
+    int err = posix_fallocate(fd, 0, (off_t)r->segment_size);
+    if (err == EOPNOTSUPP || err == EINVAL)
+        err = ftruncate(fd, (off_t)r->segment_size) < 0 ? errno : 0;
+    if (err) {
+        g_printerr("无法为 %s 分配空间: %s\n", path, strerror(err));
+        close(fd);
+        unlink(path);
+        g_free(path);
+        return NULL;
+    }
+    g_free(path);
+
+    char* map = mmap(NULL, r->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    RecSegment* seg = g_new0(RecSegment, 1);
+    seg->fd = fd;
+    seg->seq = seq;
+    seg->map = map;
+    seg->size = r->segment_size;
+    seg->hdr = (RecHeader*)map;
+    seg->names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    // 按每条记录约 8K 数据估算索引容量，字符串表占 1/16
+    size_t body = r->segment_size - REC_HEADER_SIZE;
+    RecHeader* h = seg->hdr;
+    memcpy(h->magic, REC_MAGIC, 8);
+    h->version = REC_VERSION;
+    h->header_size = REC_HEADER_SIZE;
+    h->segment_size = r->segment_size;
+    h->segment_seq = seq;
+    h->index_cap = body / (8192 + sizeof(RecIndex));
+    h->index_off = REC_HEADER_SIZE;
+    h->strtab_off = h->index_off + h->index_cap * sizeof(RecIndex);
+    h->strtab_cap = body / 16;
+    h->data_off = h->strtab_off + h->strtab_cap;
+    h->data_cap = r->segment_size - h->data_off;
+    return seg;
+}
+
+static void rec_segment_close(RecSegment* seg)
+{
+    msync(seg->map, seg->size, MS_SYNC);
+    munmap(seg->map, seg->size);
+    close(seg->fd);
+    g_hash_table_destroy(seg->names);
+    g_free(seg);
+}
+
+// 后台线程：定期 msync 当前段，回收写满的段，并提前准备下一段
+static gpointer recorder_thread(gpointer data)
+{
+    Recorder* r = data;
+    for (;;) {
+        g_mutex_lock(&r->lock);
+        gint64 deadline = g_get_monotonic_time() + (gint64)r->sync_secs * G_USEC_PER_SEC;
+        while (!r->retired && r->spare)
+            if (!g_cond_wait_until(&r->wake, &r->lock, deadline)) break;
+
+        RecSegment* retired = r->retired;
+        r->retired = NULL;
+        RecSegment* active = r->active;
+        int need_spare = r->spare == NULL;
+        guint32 spare_seq = 0;
+        if (need_spare) {
+            spare_seq = r->next_seq++;
+            r->preparing = 1;
+        }
+        guint32 newest = r->next_seq - 1;  // 磁盘上（或马上会有）的最大段号
+        g_mutex_unlock(&r->lock);
+
+        // 段只在这里 munmap，所以不持锁 msync 也是安全的
+        if (active)
+            msync(active->map, active->size, MS_ASYNC);
+
+        while (retired) {
+            RecSegment* next = retired->next;
+            rec_segment_close(retired);
+            retired = next;
+        }
+
+        // 只留 newest 往前的 keep 段；keep 至少为 2，当前段不会被删
+        while (r->keep > 0 && r->prune_seq + (guint32)r->keep <= newest) {
+            char* old = rec_segment_path(r, r->prune_seq++);
+            unlink(old);
+            g_free(old);
+        }
+
+        if (need_spare) {
+            RecSegment* seg = rec_segment_create(r, spare_seq);
+            g_mutex_lock(&r->lock);
+            r->spare = seg;
+            r->preparing = 0;
+            g_cond_broadcast(&r->wake);
+            g_mutex_unlock(&r->lock);
+            if (!seg) g_usleep((gulong)r->sync_secs * G_USEC_PER_SEC);
+        }
+    }
+    return NULL;
+}
+
+// 当前段写满：封存后交给后台线程回收，换上预分配的下一段
+static int rec_rotate(Recorder* r)
+{
+    g_mutex_lock(&r->lock);
+    // 下一段正在创建时等它完成，否则两边会用同一个段号
+    while (r->preparing)
+        g_cond_wait(&r->wake, &r->lock);
+    RecSegment* old = r->cur;
+    RecSegment* seg = r->spare;
+    r->spare = NULL;
+    guint32 seq = 0;
+    if (!seg) seq = r->next_seq++;
+    if (old) {
+        g_atomic_int_set((gint*)&old->hdr->flags, REC_SEALED);
+        old->next = r->retired;
+        r->retired = old;
+    }
+    r->cur = NULL;
+    r->active = NULL;
+    g_cond_signal(&r->wake);
+    g_mutex_unlock(&r->lock);
+
+    // 后台线程还没准备好时才在采集线程里创建
+    if (!seg) seg = rec_segment_create(r, seq);
+    if (!seg) return 0;
+
+    g_mutex_lock(&r->lock);
+    r->cur = seg;
+    r->active = seg;
+    g_mutex_unlock(&r->lock);
+    return 1;
+}
+
+Recorder* recorder_open(const char* path, int size_mb, int keep, int sync_secs)
+{
+    Recorder* r = g_new0(Recorder, 1);
+    r->path = g_strdup(path);
+    r->segment_size = (size_t)MAX(size_mb, 1) << 20;
+    // 当前段和预分配的下一段总在磁盘上，保留数不能比 2 少
+    r->keep = keep > 0 ? MAX(keep, 2) : 0;
+    r->sync_secs = MAX(sync_secs, 1);
+    g_mutex_init(&r->lock);
+    g_cond_init(&r->wake);
+
+    // 接着已有的最大段号继续编号；前面的段可能已被删掉，所以不能从 0 逐个探测。
+    // glob 的结果按名字排序，段号定长，第一个就是最早的段
+    char* pattern = g_strdup_printf("%s.[0-9][0-9][0-9][0-9][0-9][0-9]", r->path);
+    glob_t g;
+    if (glob(pattern, 0, NULL, &g) == 0) {
+        size_t suffix = strlen(r->path) + 1;
+        r->prune_seq = (guint32)strtoul(g.gl_pathv[0] + suffix, NULL, 10);
+        r->next_seq = (guint32)strtoul(g.gl_pathv[g.gl_pathc - 1] + suffix, NULL, 10) + 1;
+        globfree(&g);
+    }
+    g_free(pattern);
+
+    if (!rec_rotate(r)) {
+        g_free(r->path);
+        g_free(r);
+        return NULL;
+    }
+    g_thread_new("recorder", recorder_thread, r);
+    return r;
+}
+
+// 返回进程名在字符串表中的偏移，同一段内重复的名字只存一次
+static int rec_intern(RecSegment* seg, const char* name, guint32* off)
+{
+    gpointer v = g_hash_table_lookup(seg->names, name);
+    if (v) {
+        *off = GPOINTER_TO_UINT(v) - 1;
+        return 1;
+    }
+
+    RecHeader* h = seg->hdr;
+    size_t len = strlen(name) + 1;
+    if (h->strtab_used + len > h->strtab_cap) return 0;
+
+    memcpy(seg->map + h->strtab_off + h->strtab_used, name, len);
+    *off = (guint32)h->strtab_used;
+    h->strtab_used += len;
+    g_hash_table_insert(seg->names, g_strdup(name), GUINT_TO_POINTER(*off + 1));
+    return 1;
+}
+
+// 写入一条记录；空间不够返回 0，由调用者换段重试
+static int rec_append(RecSegment* seg, const Snapshot* s)
+{
+    RecHeader* h = seg->hdr;
+    guint n = s->procs->len;
+    size_t len = sizeof(RecSystem) + (size_t)n * sizeof(RecProc);
+    // RecProc 是 20 字节，补齐后下一条的 RecSystem 才是对齐的
+    size_t padded = (len + _Alignof(RecSystem) - 1) & ~(_Alignof(RecSystem) - 1);
+
+    if (h->n_records >= h->index_cap) return 0;
+    if (h->data_used + padded > h->data_cap) return 0;
+
+    if (h->n_records == 0) {
+        h->created_wall_us = s->wall_us;
+        g_strlcpy(h->cpu_model, s->cpu_info.model, sizeof(h->cpu_model));
+        h->cpu_cores = s->cpu_info.cores;
+        h->cpu_threads = s->cpu_info.threads;
+    }
+
+    guint64 strtab_used = h->strtab_used;
+    char* p = seg->map + h->data_off + h->data_used;
+
+    RecSystem* sys = (RecSystem*)p;
+    sys->cpu_p = s->sys.cpu_p;
+    sys->mem_p = s->sys.mem_p;
+    sys->disk_kb = s->sys.disk_kb;
+    sys->disk_read_kb = s->sys.disk_total.read_kb;
+    sys->disk_write_kb = s->sys.disk_total.write_kb;
+    sys->disk_busy = s->sys.disk_total.busy;
+    sys->freq_ghz = s->cpu_info.freq_ghz;
+    sys->mem = s->sys.mem;
+
+    RecProc* procs = (RecProc*)(p + sizeof(RecSystem));
+    for (guint i = 0; i < n; i++) {
+        const ProcRow* row = &g_array_index(s->procs, ProcRow, i);
+        RecProc* rp = &procs[i];
+        if (!rec_intern(seg, row->name, &rp->name_off)) {
+            // 字符串表满了：撤销本条记录新增的名字，换段重写
+            h->strtab_used = strtab_used;
+            g_hash_table_remove_all(seg->names);
+            return 0;
+        }
+        rp->pid = row->pid;
+        rp->cpu = (float)row->cpu;
+        rp->mem = (float)row->mem;
+        rp->io_kb = (float)row->io_kb;
+    }
+
+    RecIndex* idx = (RecIndex*)(seg->map + h->index_off) + h->n_records;
+    idx->time_us = s->time_us;
+    idx->wall_us = s->wall_us;
+    idx->data_off = h->data_used;
+    idx->data_len = (guint32)len;
+    idx->n_procs = n;
+
+    // 数据和索引写完后再发布计数，崩溃时最多丢掉正在写的这一条
+    h->data_used += padded;
+    __atomic_store_n(&h->n_records, h->n_records + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void record_snapshot(Recorder* r, const Snapshot* s)
+{
+    if (!r || !s->procs) return;
+    if (r->cur && rec_append(r->cur, s)) return;
+
+    // 单条记录比整个段还大时放弃本轮，避免无限换段
+    if (!rec_rotate(r) || !rec_append(r->cur, s))
+        g_warning("录制：第 %u 段放不下 %u 个进程的记录", r->cur ? r->cur->seq : 0, s->procs->len);
+}
+
+/* ================= 可见性调度 ================= */
+// 主线程记录哪些面板可见、窗口是否显示和有焦点，采集线程据此决定本轮采什么、隔多久采：
+// 进程列表不可见时不扫描 /proc/PID，CPU 页不可见时不读 /proc/cpuinfo，
+// 窗口最小化时只读系统计数并放慢到 SCHED_HIDDEN_FACTOR 倍间隔。
+// 系统计数每轮都读，进程条目记着上次采样时的系统总时间，所以恢复可见后第一轮的差值就是对的。
+#define SCHED_HIDDEN_FACTOR 5
+#define SCHED_JITTER_WINDOW 128
+
+static gint view_mask = VIEW_ALL;       // 无界面模式保持全部可见
+static gint sched_forced = 0;           // 有面板刚变为可见，下一轮不做降频
+static int sched_boost = 0;             // sched_sleep 醒来时取走的 sched_forced，只在采集线程使用
+static GMutex sched_lock;
+static GCond sched_cond;
+
+void sched_wake()
+{
+    g_atomic_int_set(&sched_forced, 1);
+    g_mutex_lock(&sched_lock);
+    g_cond_signal(&sched_cond);
+    g_mutex_unlock(&sched_lock);
+}
+
+// 每轮的预定时刻 = 上一轮预定时刻 + 间隔，按单调时钟对齐，采集耗时不会累积成漂移。
+// 落后超过一整个间隔时跳过错过的轮次，不连续补采。
+static gint64 sched_next_us = 0;
+static gint64 jitter_ring[SCHED_JITTER_WINDOW];
+static int jitter_n = 0;
+static int jitter_head = 0;
+
+static int compare_jitter(const void* a, const void* b)
+{
+    gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+    return (x > y) - (x < y);
+}
+
+gint64 sched_jitter_p99()
+{
+    gint64 v[SCHED_JITTER_WINDOW];
+    if (jitter_n == 0) return 0;
+    memcpy(v, jitter_ring, jitter_n * sizeof(gint64));
+    qsort(v, jitter_n, sizeof(gint64), compare_jitter);
+    return v[(jitter_n - 1) * 99 / 100];
+}
+
+// 睡到下一轮的预定时刻，期间有面板变为可见时提前返回；返回本轮的抖动
+gint64 sched_sleep()
+{
+    gint64 interval = (gint64)(flash_time * G_USEC_PER_SEC);
+    if (!(g_atomic_int_get(&view_mask) & VIEW_MAPPED))
+        interval *= SCHED_HIDDEN_FACTOR;
+
+    gint64 now = g_get_monotonic_time();
+    if (sched_next_us == 0) {
+        sched_next_us = now;
+        sched_boost = g_atomic_int_and(&sched_forced, 0);
+        return 0;
+    }
+    sched_next_us += interval;
+    if (sched_next_us + interval <= now)
+        sched_next_us += (now - sched_next_us) / interval * interval;
+
+    g_mutex_lock(&sched_lock);
+    while (!g_atomic_int_get(&sched_forced))
+        if (!g_cond_wait_until(&sched_cond, &sched_lock, sched_next_us)) break;
+    // 醒来就清掉唤醒标志，否则下一次等待会立即返回，采集线程空转
+    sched_boost = g_atomic_int_and(&sched_forced, 0);
+    g_mutex_unlock(&sched_lock);
+
+    gint64 woke = g_get_monotonic_time();
+    if (woke < sched_next_us) {
+        // 被提前唤醒，从现在重新对齐
+        sched_next_us = woke;
+        return 0;
+    }
+
+    gint64 jitter = woke - sched_next_us;
+    jitter_ring[jitter_head] = jitter;
+    jitter_head = (jitter_head + 1) % SCHED_JITTER_WINDOW;
+    if (jitter_n < SCHED_JITTER_WINDOW) jitter_n++;
+    return jitter;
+}
+
+int sched_collect_flags(guint tick)
+{
+    int mask = g_atomic_int_get(&view_mask);
+    int cgroups = (mask & VIEW_MAPPED) && (mask & VIEW_CGROUP) ? COLLECT_CGROUPS : 0;
+
+    // 录制需要完整数据；cgroup 不录制，只在可见时采集
+    if (recorder) return COLLECT_ALL | cgroups;
+
+    int forced = sched_boost;
+    int what = cgroups;
+    if (!(mask & VIEW_MAPPED)) return what;
+
+    // 窗口没有焦点时进程列表隔一轮刷新一次
+    if ((mask & VIEW_PROCESS) && ((mask & VIEW_FOCUSED) || forced || tick % 2 == 0))
+        what |= COLLECT_PROCS;
+    if (mask & VIEW_PERF_CPU)
+        what |= COLLECT_CPU_INFO;
+    return what;
+}
+
+// 主线程在页面切换、窗口映射/最小化、焦点变化时调用
+void update_view_mask()
+{
+    int mask = 0;
+    GdkWindow* gw = main_window ? gtk_widget_get_window(main_window) : NULL;
+    if (gw && gtk_widget_get_mapped(main_window) &&
+        !(gdk_window_get_state(gw) & (GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN)))
+        mask |= VIEW_MAPPED;
+    if (main_window && gtk_window_is_active(GTK_WINDOW(main_window)))
+        mask |= VIEW_FOCUSED;
+
+    const char* page = main_stack ? gtk_stack_get_visible_child_name(GTK_STACK(main_stack)) : NULL;
+    if (page && strcmp(page, "process") == 0)
+        mask |= VIEW_PROCESS;
+    else if (page && strcmp(page, "cgroup") == 0)
+        mask |= VIEW_CGROUP;
+    else if (page && strcmp(page, "performance") == 0) {
+        const char* sub = gtk_stack_get_visible_child_name(GTK_STACK(perf_stack));
+        if (sub && strcmp(sub, "cpu") == 0)
+            mask |= VIEW_PERF_CPU;
+    }
+
+    int old = g_atomic_int_get(&view_mask);
+    g_atomic_int_set(&view_mask, mask);
+    if (mask & ~old) sched_wake();
+}
+
+static void on_view_notify(GObject* obj, GParamSpec* pspec, gpointer data)
+{
+    update_view_mask();
+}
+
+static gboolean on_view_event(GtkWidget* widget, GdkEvent* event, gpointer data)
+{
+    update_view_mask();
+    return FALSE;
+}
+
+// 线程视图展开且选中了进程时，让采集线程扫描该进程的线程
+void update_thread_target()
+{
+    int pid = -1;
+    if (gtk_expander_get_expanded(GTK_EXPANDER(thread_expander))) {
+        GtkTreeSelection* sel = gtk_tree_view_get_selection(GTK_TREE_VIEW(process_tree_view));
+        GtkTreeModel* model;
+        GtkTreeIter iter;
+        if (gtk_tree_selection_get_selected(sel, &model, &iter))
+            gtk_tree_model_get(model, &iter, COL_PID, &pid, -1);
+    }
+
+    if (pid != g_atomic_int_get(&thread_pid)) {
+        g_atomic_int_set(&thread_pid, pid);
+        if (pid > 0) sched_wake();
+    }
+}
+
+static void on_thread_selection_changed(GtkTreeSelection* sel, gpointer data)
+{
+    update_thread_target();
+}
+
+static void on_thread_expanded(GObject* obj, GParamSpec* pspec, gpointer data)
+{
+    update_thread_target();
+}
+
+/* ================= 快照来源 ================= */
+// 采集线程只从 SnapshotSource 取快照：实时来源读 /proc，回放来源读录制文件。
+// next() 阻塞到下一份快照该出现的时刻，没有更多数据时返回 NULL。
+typedef struct SnapshotSource {
+    Snapshot* (*next)(struct SnapshotSource* src);
+} SnapshotSource;
+
+static Snapshot* live_next(SnapshotSource* src)
+{
+    static guint tick = 0;
+    gint64 jitter = sched_sleep();
+
+    Snapshot* s = collect_snapshot_with(sched_collect_flags(tick++));
+    s->jitter_us = jitter;
+    s->jitter_p99_us = sched_jitter_p99();
+    return s;
+}
+
+static SnapshotSource live_source = { live_next };
+static SnapshotSource* snapshot_source = &live_source;
+
+// 录制文件可能被截断或改坏，映射时先检查各区域都在文件内、计数不超过容量
+static int rec_header_valid(const RecHeader* h, guint64 n_records)
+{
+    guint64 size = h->segment_size;
+    if (h->index_off < REC_HEADER_SIZE || h->index_off > size) return 0;
+    if (h->index_cap > (size - h->index_off) / sizeof(RecIndex)) return 0;
+    if (h->strtab_off > size || h->strtab_cap > size - h->strtab_off) return 0;
+    if (h->data_off > size || h->data_cap > size - h->data_off) return 0;
+    return n_records <= h->index_cap && h->strtab_used <= h->strtab_cap && h->data_used <= h->data_cap;
+}
+
+// 一条记录的数据要落在已提交的数据区内，并且放得下 n_procs 个进程
+static int rec_index_valid(const RecHeader* h, const RecIndex* idx)
+{
+    if (idx->data_off > h->data_used || idx->data_len > h->data_used - idx->data_off) return 0;
+    if (idx->data_len < sizeof(RecSystem)) return 0;
+    return idx->n_procs <= (idx->data_len - sizeof(RecSystem)) / sizeof(RecProc);
+}
+
+// 回放：把所有段只读映射进来，按记录顺序建一张平铺的索引
+typedef struct {
+    const char* base;           // 段文件映射起点
+    const RecHeader* hdr;
+    const RecIndex* idx;
+} ReplayRecord;
+
+#define REPLAY_MAX_GAP_US (10 * G_USEC_PER_SEC)   // 两次录制之间的空档最多等 10 秒
+
+typedef struct {
+    SnapshotSource src;
+    GArray* records;            // ReplayRecord
+
+    GMutex lock;                // 保护下面几项，界面线程通过 replay_seek 等修改
+    GCond wake;
+    int pos;                    // 下一条要播放的记录
+    int speed;                  // 倍速 1~100
+    int paused;
+    int seeked;                 // 跳转后的第一份快照与之前不连续
+    int stop_at_end;            // 播完后返回 NULL，而不是等待跳转
+    gint64 due_us;              // pos 应该播放的时刻
+} ReplaySource;
+
+static ReplaySource* replay = NULL;
+static gchar* opt_replay = NULL;
+static int replay_speed = 1;
+
+static int replay_map_segment(ReplaySource* r, const char* path)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < REC_HEADER_SIZE) {
+        close(fd);
+        return 0;
+    }
+    // MAP_SHARED：正在录制的文件也能读到已经提交的记录
+    char* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    const RecHeader* h = (const RecHeader*)map;
+    if (memcmp(h->magic, REC_MAGIC, 8) != 0 || h->version != REC_VERSION || h->segment_size != (guint64)st.st_size) {
+        munmap(map, st.st_size);
+        return 0;
+    }
+
+    guint64 n = __atomic_load_n(&h->n_records, __ATOMIC_ACQUIRE);
+    if (!rec_header_valid(h, n)) {
+        g_printerr("%s: 录制文件头已损坏，跳过整段\n", path);
+        munmap(map, st.st_size);
+        return 0;
+    }
+
+    const RecIndex* idx = (const RecIndex*)(map + h->index_off);
+    guint bad = 0;
+    for (guint64 i = 0; i < n; i++) {
+        if (!rec_index_valid(h, &idx[i])) {
+            bad++;
+            continue;
+        }
+        ReplayRecord rec = { map, h, &idx[i] };
+        g_array_append_val(r->records, rec);
+    }
+    if (bad)
+        g_printerr("%s: 跳过 %u 条损坏的记录\n", path, bad);
+    return 1;
+}
+
+// 回放时字符串表中的名字：偏移越界或没有 '\0' 结尾时返回 NULL
+static const char* rec_name(const RecHeader* h, const char* base, guint32 off, int* len)
+{
+    guint64 used = MIN(h->strtab_used, h->strtab_cap);
+    if (off >= used) return NULL;
+    const char* name = base + h->strtab_off + off;
+    const char* end = memchr(name, '\0', used - off);
+    if (!end) return NULL;
+    *len = (int)(end - name);
+    return name;
+}
+
+// 把第 i 条记录还原成和实时采集一样的 Snapshot
+Snapshot* replay_build(const ReplaySource* r, int i)
+{
+    const ReplayRecord* rec = &g_array_index(r->records, ReplayRecord, i);
+    const RecHeader* h = rec->hdr;
+    const char* data = rec->base + h->data_off + rec->idx->data_off;
+    const RecSystem* sys = (const RecSystem*)data;
+    const RecProc* procs = (const RecProc*)(data + sizeof(RecSystem));
+
+    Snapshot* s = g_new0(Snapshot, 1);
+    s->time_us = rec->idx->time_us;
+    s->wall_us = rec->idx->wall_us;
+    s->seq = i;
+
+    s->sys.cpu_p = sys->cpu_p;
+    s->sys.mem_p = sys->mem_p;
+    s->sys.disk_kb = sys->disk_kb;
+    s->sys.disk_total.read_kb = sys->disk_read_kb;
+    s->sys.disk_total.write_kb = sys->disk_write_kb;
+    s->sys.disk_total.busy = sys->disk_busy;
+    s->sys.mem = sys->mem;
+    s->sys.mem_ok = sys->mem.mem_total > 0;
+    s->sys.disk_ok = 1;
+
+    // 文件头里的型号不一定以 '\0' 结尾，按字段长度截断
+    snprintf(s->cpu_info.model, sizeof(s->cpu_info.model), "%.*s", (int)sizeof(h->cpu_model), h->cpu_model);
+    s->cpu_info.cores = h->cpu_cores;
+    s->cpu_info.threads = h->cpu_threads;
+    s->cpu_info.freq_ghz = sys->freq_ghz;
+    s->cpu_info.usage_percent = sys->cpu_p;
+
+    // 录制文件里没有用户和 cmdline，搜索键只有 PID 和名字。
+    // 名字偏移坏掉的进程显示为 "?"，整个回放只提示一次
+    static gboolean warned = FALSE;
+    guint n = rec->idx->n_procs;
+    s->procs = g_array_sized_new(FALSE, FALSE, sizeof(ProcRow), n);
+    s->keys = g_string_sized_new(n * 16);
+    g_array_set_size(s->procs, n);
+    for (guint j = 0; j < n; j++) {
+        ProcRow* row = &g_array_index(s->procs, ProcRow, j);
+        row->pid = procs[j].pid;
+        int len;
+        const char* name = rec_name(h, rec->base, procs[j].name_off, &len);
+        if (name) {
+            len = MIN(len, (int)sizeof(row->name) - 1);
+            memcpy(row->name, name, len);
+            row->name[len] = '\0';
+        }
+        else {
+            strcpy(row->name, "?");
+            if (!warned) g_printerr("回放：第 %d 条记录中有进程名偏移越界\n", i);
+            warned = TRUE;
+        }
+        row->cpu = procs[j].cpu;
+        row->mem = procs[j].mem;
+        row->io_kb = procs[j].io_kb;
+        row->ppid = 0;
+        row->key_off = (guint32)s->keys->len;
+        search_key_append(s->keys, row->pid, row->name, NULL, NULL, NULL);
+    }
+    return s;
+}
+
+static Snapshot* replay_next(SnapshotSource* src)
+{
+    ReplaySource* r = (ReplaySource*)src;
+    int len = (int)r->records->len;
+
+    g_mutex_lock(&r->lock);
+    for (;;) {
+        if (r->pos >= len && r->stop_at_end) {
+            g_mutex_unlock(&r->lock);
+            return NULL;
+        }
+        // 暂停或播完时等界面跳转/继续
+        if (r->paused || r->pos >= len) {
+            g_cond_wait(&r->wake, &r->lock);
+            continue;
+        }
+        if (g_get_monotonic_time() < r->due_us) {
+            g_cond_wait_until(&r->wake, &r->lock, r->due_us);
+            continue;
+        }
+        break;
+    }
+
+    int pos = r->pos++;
+    int seeked = r->seeked;
+    r->seeked = 0;
+    if (r->pos < len) {
+        gint64 gap = g_array_index(r->records, ReplayRecord, r->pos).idx->time_us
+            - g_array_index(r->records, ReplayRecord, pos).idx->time_us;
+        gap = CLAMP(gap, 0, REPLAY_MAX_GAP_US);
+        r->due_us = g_get_monotonic_time() + gap / r->speed;
+    }
+    g_mutex_unlock(&r->lock);
+
+    Snapshot* s = replay_build(r, pos);
+    s->discontinuous = seeked;
+    return s;
+}
+
+// path 可以是单个段文件，也可以是 --record 时给的前缀
+ReplaySource* replay_open(const char* path, int speed)
+{
+    ReplaySource* r = g_new0(ReplaySource, 1);
+    r->src.next = replay_next;
+    r->records = g_array_new(FALSE, FALSE, sizeof(ReplayRecord));
+    r->speed = CLAMP(speed, 1, 100);
+    g_mutex_init(&r->lock);
+    g_cond_init(&r->wake);
+
+    if (!replay_map_segment(r, path)) {
+        char* pattern = g_strdup_printf("%s.[0-9][0-9][0-9][0-9][0-9][0-9]", path);
+        glob_t g;
+        if (glob(pattern, 0, NULL, &g) == 0) {
+            for (size_t i = 0; i < g.gl_pathc; i++)
+                replay_map_segment(r, g.gl_pathv[i]);
+            globfree(&g);
+        }
+        g_free(pattern);
+    }
+
+    if (r->records->len == 0) {
+        g_printerr("%s 中没有可回放的记录\n", path);
+        g_array_free(r->records, TRUE);
+        g_free(r);
+        return NULL;
+    }
+    return r;
+}
+
+void replay_seek(ReplaySource* r, int pos)
+{
+    g_mutex_lock(&r->lock);
+    r->pos = CLAMP(pos, 0, (int)r->records->len - 1);
+    r->seeked = 1;
+    r->due_us = 0;
+    g_cond_signal(&r->wake);
+    g_mutex_unlock(&r->lock);
+}
+
+void replay_set_speed(ReplaySource* r, int speed)
+{
+    g_mutex_lock(&r->lock);
+    r->speed = CLAMP(speed, 1, 100);
+    g_cond_signal(&r->wake);
+    g_mutex_unlock(&r->lock);
+}
+
+void replay_set_paused(ReplaySource* r, int paused)
+{
+    g_mutex_lock(&r->lock);
+    r->paused = paused;
+    g_cond_signal(&r->wake);
+    g_mutex_unlock(&r->lock);
+}
+
+/* ================= 回放控制 ================= */
+static GtkWidget* replay_scale = NULL;
+static GtkWidget* replay_time_label = NULL;
+static const int replay_speeds[] = { 1, 2, 5, 10, 20, 50, 100 };
+
+// change-value 只在用户拖动时触发，播放时 update_replay_bar 设置位置不会引起跳转
+static gboolean on_replay_scale_changed(GtkRange* range, GtkScrollType scroll, gdouble value, gpointer data)
+{
+    replay_seek(replay, (int)(value + 0.5));
+    return FALSE;
+}
+
+static void on_replay_pause_toggled(GtkToggleButton* btn, gpointer data)
+{
+    int paused = gtk_toggle_button_get_active(btn);
+    gtk_button_set_label(GTK_BUTTON(btn), paused ? "播放" : "暂停");
+    replay_set_paused(replay, paused);
+}
+
+static void on_replay_speed_changed(GtkComboBox* combo, gpointer data)
+{
+    int i = gtk_combo_box_get_active(combo);
+    if (i >= 0) replay_set_speed(replay, replay_speeds[i]);
+}
+
+void update_replay_bar(const Snapshot* s)
+{
+    if (!replay_scale || s->seq < 0) return;
+
+    gtk_range_set_value(GTK_RANGE(replay_scale), s->seq);
+
+    GDateTime* dt = g_date_time_new_from_unix_local(s->wall_us / G_USEC_PER_SEC);
+    gchar* when = g_date_time_format(dt, "%Y-%m-%d %H:%M:%S");
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s  %d / %u", when, s->seq + 1, replay->records->len);
+    gtk_label_set_text(GTK_LABEL(replay_time_label), buf);
+    g_free(when);
+    g_date_time_unref(dt);
+}
+
+GtkWidget* create_replay_bar()
+{
+    GtkWidget* bar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_widget_set_margin_start(bar, 10);
+    gtk_widget_set_margin_end(bar, 10);
+
+    GtkWidget* pause_btn = gtk_toggle_button_new_with_label("暂停");
+    g_signal_connect(pause_btn, "toggled", G_CALLBACK(on_replay_pause_toggled), NULL);
+    gtk_box_pack_start(GTK_BOX(bar), pause_btn, FALSE, FALSE, 0);
+
+    double last = MAX((int)replay->records->len - 1, 1);
+    replay_scale = gtk_scale_new_with_range(GTK_ORIENTATION_HORIZONTAL, 0, last, 1);
+    gtk_scale_set_draw_value(GTK_SCALE(replay_scale), FALSE);
+    g_signal_connect(replay_scale, "change-value", G_CALLBACK(on_replay_scale_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(bar), replay_scale, TRUE, TRUE, 0);
+
+    replay_time_label = gtk_label_new("");
+    gtk_box_pack_start(GTK_BOX(bar), replay_time_label, FALSE, FALSE, 0);
+
+    GtkWidget* speed_combo = gtk_combo_box_text_new();
+    int active = 0;
+    for (int i = 0; i < (int)G_N_ELEMENTS(replay_speeds); i++) {
+        char label[16];
+        snprintf(label, sizeof(label), "%dx", replay_speeds[i]);
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(speed_combo), label);
+        if (replay_speeds[i] <= replay->speed) active = i;
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(speed_combo), active);
+    g_signal_connect(speed_combo, "changed", G_CALLBACK(on_replay_speed_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(bar), speed_combo, FALSE, FALSE, 0);
+
+    return bar;
+}
+
+/* ================= 快照交接 ================= */
+// 采集线程把最新快照放进 pending_snapshot，主线程取走后只负责刷新界面。
+// 主线程来不及处理时旧快照直接丢弃，界面总是显示最新的数据。
+static Snapshot* pending_snapshot = NULL;
+static gint apply_queued = 0;
+
+Snapshot* snapshot_exchange(Snapshot* s)
+{
+    Snapshot* old;
+    do {
+        old = g_atomic_pointer_get(&pending_snapshot);
+    } while (!g_atomic_pointer_compare_and_exchange(&pending_snapshot, old, s));
+    return old;
+}
+
+gboolean apply_snapshot(gpointer data)
+{
+    g_atomic_int_set(&apply_queued, 0);
+
+    Snapshot* s = snapshot_exchange(NULL);
+    if (!s) return G_SOURCE_REMOVE;
+
+    update_process_list(s);
+    update_thread_list(s);
+    update_cgroup_list(s);
+    update_system_summary(s);
+    update_system_total(s);
+    update_cpu_detail_label(s);
+    update_cpu_cores(s);
+    update_memory_info(s);
+    update_disk_info(s);
+    update_psi_info(s);
+    update_net_info(s);
+    update_replay_bar(s);
+
+    g_debug("fd cache: %d fds open, %ld syscalls saved this tick", s->fd_open, s->fd_saved);
+    g_debug("proc tracks: %d live, %d allocated", s->tracks_live, s->tracks_pooled);
+    g_debug("tick: %.1f ms elapsed, jitter %.2f ms (p99 %.2f ms)",
+        s->sys.elapsed_s * 1000.0, s->jitter_us / 1000.0, s->jitter_p99_us / 1000.0);
+    if (s->procs)
+        g_debug("scan: %u pids in %.2f ms with %d workers", s->procs->len, s->scan_us / 1000.0, s->scan_workers);
+
+    snapshot_free(s);
+    return G_SOURCE_REMOVE;
+}
+
+gpointer collector_thread(gpointer data)
+{
+    for (;;) {
+        Snapshot* s = snapshot_source->next(snapshot_source);
+        if (!s) break;
+        record_snapshot(recorder, s);
+
+        Snapshot* old = snapshot_exchange(s);
+        snapshot_free(old);
+
+        if (g_atomic_int_compare_and_exchange(&apply_queued, 0, 1))
+            g_idle_add(apply_snapshot, NULL);
+    }
+    return NULL;
+}
+
+
+//标签创建
+GtkWidget* create_cpu_info_label(GtkWidget* parent)
+{
+    cpu_detail_label = gtk_label_new("正在获取 CPU 信息...");
+    gtk_widget_set_halign(cpu_detail_label, GTK_ALIGN_START);
+    gtk_widget_set_valign(cpu_detail_label, GTK_ALIGN_START);
+
+    return cpu_detail_label;
+}
+
+//进程面板
+// 进程列表的数据模型，不依赖 TreeView，基准测试也直接用它
+void create_process_models()
+{
+    proc_model = g_object_new(PROC_TYPE_MODEL, NULL);
+}
+
+/* 树状视图：数值列显示子树合计，双击有子进程的行展开/折叠 */
+void on_tree_mode_toggled(GtkToggleButton* button, gpointer user_data)
+{
+    process_view_refresh(proc_model_set_tree_mode(proc_model, gtk_toggle_button_get_active(button)));
+    process_view_reselect();
+}
+
+void on_process_row_activated(GtkTreeView* view, GtkTreePath* path, GtkTreeViewColumn* column, gpointer user_data)
+{
+    if (!proc_model->tree_mode) return;
+    int pos = gtk_tree_path_get_indices(path)[0];
+    if (pos < 0 || (guint)pos >= proc_model->n_view) return;
+    if (!proc_tree_toggle(proc_model->pid[proc_model->view[pos]])) return;
+
+    guint old_n = proc_model->n_view;
+    proc_model_rebuild_view(proc_model);
+    process_view_refresh(old_n);
+    process_view_reselect();
+}
+
+GtkWidget* create_process_panel()
+{
+
+    process_panel_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    // 系统状态标签
+    sys_label = gtk_label_new("System Total | CPU: 0% | MEM: 0% | Disk: 0 KB/s");
+    gtk_box_pack_start(GTK_BOX(process_panel_box), sys_label, FALSE, FALSE, 5);
+
+    create_process_models();
+    process_tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(proc_model));
+    // 固定行高，TreeView 不必为了量尺寸读取所有行
+    gtk_tree_view_set_fixed_height_mode(GTK_TREE_VIEW(process_tree_view), TRUE);
+    g_signal_connect(process_tree_view, "row-activated", G_CALLBACK(on_process_row_activated), NULL);
 
     // 滚动窗口
     GtkWidget* scroll = gtk_scrolled_window_new(NULL, NULL);
     gtk_container_add(GTK_CONTAINER(scroll), process_tree_view);
     gtk_box_pack_start(GTK_BOX(process_panel_box), scroll, TRUE, TRUE, 0);
 
-    // ------------------ 底部搜索 + 结束任务 ------------------
-    GtkWidget* bottom_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    // ------------------ 线程视图 ------------------
+    // 展开后显示选中进程的线程，收起时不扫描 /proc/PID/task
+    thread_store = gtk_list_store_new(NUM_TCOLS,
+        G_TYPE_INT,
+        G_TYPE_STRING,
+        G_TYPE_STRING,
+        G_TYPE_INT,
+        G_TYPE_DOUBLE);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(thread_store), TCOL_CPU, GTK_SORT_DESCENDING);
+    thread_tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(thread_store));
+
+    const char* thread_titles[NUM_TCOLS] = { "TID", "线程名", "状态", "CPU 核", "CPU%" };
+    for (int i = 0; i < NUM_TCOLS; i++) {
+        GtkTreeViewColumn* col = gtk_tree_view_column_new_with_attributes(thread_titles[i],
+            gtk_cell_renderer_text_new(), "text", i, NULL);
+        gtk_tree_view_column_set_sort_column_id(col, i);
+        gtk_tree_view_column_set_resizable(col, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(thread_tree_view), col);
+    }
+
+    GtkWidget* thread_scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_widget_set_size_request(thread_scroll, -1, 180);
+    gtk_container_add(GTK_CONTAINER(thread_scroll), thread_tree_view);
+
+    thread_expander = gtk_expander_new("线程");
+    gtk_container_add(GTK_CONTAINER(thread_expander), thread_scroll);
+    gtk_box_pack_start(GTK_BOX(process_panel_box), thread_expander, FALSE, FALSE, 0);
+    g_signal_connect(thread_expander, "notify::expanded", G_CALLBACK(on_thread_expanded), NULL);
+
+    // ------------------ 底部搜索 + 结束任务 ------------------
+    GtkWidget* bottom_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+
+    GtkWidget* search_label = gtk_label_new("搜索：");
+    search_entry = gtk_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(search_entry), "名称 / PID / 用户 / cgroup / 命令行");
+    gtk_widget_set_tooltip_text(search_entry,
+        "空格分隔的多个条件需全部匹配，不区分大小写\n"
+        "pid:123  name:bash  user:root  cg:nginx.service  cmd:--config 只在该字段中查找");
+    gtk_box_pack_start(GTK_BOX(bottom_box), search_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(bottom_box), search_entry, TRUE, TRUE, 0);
+    g_signal_connect(search_entry, "changed", G_CALLBACK(on_search_changed), NULL);
+
+    GtkWidget* tree_btn = gtk_check_button_new_with_label("树状视图");
+    gtk_widget_set_tooltip_text(tree_btn, "按父子关系显示，数值为整棵子树的合计；双击行展开/折叠");
+    g_signal_connect(tree_btn, "toggled", G_CALLBACK(on_tree_mode_toggled), NULL);
+    gtk_box_pack_start(GTK_BOX(bottom_box), tree_btn, FALSE, FALSE, 0);
+
+    GtkWidget* kill_btn = gtk_button_new_with_label("结束任务");
+    g_signal_connect(kill_btn, "clicked", G_CALLBACK(on_kill_task_clicked), NULL);
+    gtk_box_pack_end(GTK_BOX(bottom_box), kill_btn, FALSE, FALSE, 0);
+
+    gtk_box_pack_start(GTK_BOX(process_panel_box), bottom_box, FALSE, FALSE, 5);
+
+    // ------------------ 列标题及渲染器 ------------------
+    const char* titles[NUM_COLS] = { "PID", "Name", "CPU%", "MEM%", "Disk KB/s" };
+    const int widths[NUM_COLS] = { 80, 240, 100, 100, 120 };
+    for (int i = 0; i < NUM_COLS; i++) {
+        GtkTreeViewColumn* col = gtk_tree_view_column_new();
+        gtk_tree_view_column_set_title(col, titles[i]);
+        gtk_tree_view_column_set_sizing(col, GTK_TREE_VIEW_COLUMN_FIXED);
+        gtk_tree_view_column_set_fixed_width(col, widths[i]);
+        gtk_tree_view_column_set_resizable(col, TRUE);
+        renderers[i] = GTK_CELL_RENDERER_TEXT(gtk_cell_renderer_text_new());
+        gtk_tree_view_column_pack_start(col, GTK_CELL_RENDERER(renderers[i]), TRUE);
+        gtk_tree_view_column_add_attribute(col, GTK_CELL_RENDERER(renderers[i]), "text", i);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(process_tree_view), col);
+
+        g_object_set_data(G_OBJECT(col), "col_index", GINT_TO_POINTER(i));
+        g_signal_connect(col, "clicked", G_CALLBACK(column_clicked), NULL);
+        gtk_tree_view_column_set_sort_column_id(col, i);
+
+        columns[i] = col;
+        g_signal_connect(gtk_tree_view_column_get_button(col), "button-press-event",
+            G_CALLBACK(on_column_header_pressed), NULL);
+    }
+
+    // 列显示菜单，PID 和 Name 始终显示
+    column_menu = gtk_menu_new();
+    for (int i = COL_CPU; i < NUM_COLS; i++) {
+        GtkWidget* item = gtk_check_menu_item_new_with_label(titles[i]);
+        gtk_check_menu_item_set_active(GTK_CHECK_MENU_ITEM(item), TRUE);
+        g_signal_connect(item, "toggled", G_CALLBACK(on_column_toggled), columns[i]);
+        gtk_menu_shell_append(GTK_MENU_SHELL(column_menu), item);
+    }
+    gtk_widget_show_all(column_menu);
+
+    g_signal_connect(process_tree_view, "cursor-changed", G_CALLBACK(on_row_selected), NULL);
+    g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(process_tree_view)), "changed",
+        G_CALLBACK(on_thread_selection_changed), NULL);
+
+    return process_panel_box;
+}
+
+static void on_cgroup_selection_changed(GtkTreeSelection* sel, gpointer data)
+{
+    GtkTreeModel* model;
+    GtkTreeIter iter;
+    char* path = NULL;
+    if (gtk_tree_selection_get_selected(sel, &model, &iter))
+        gtk_tree_model_get(model, &iter, CGCOL_PATH, &path, -1);
+    cgroup_set_selected(path);
+    g_free(path);
+    sched_wake();
+}
+
+// 双击 cgroup 跳到进程页，按 cg: 搜索组内（含子组）的进程
+void on_cgroup_row_activated(GtkTreeView* view, GtkTreePath* path, GtkTreeViewColumn* column, gpointer user_data)
+{
+    GtkTreeModel* model = gtk_tree_view_get_model(view);
+    GtkTreeIter iter;
+    if (!gtk_tree_model_get_iter(model, &iter, path)) return;
+
+    char* cg;
+    gtk_tree_model_get(model, &iter, CGCOL_PATH, &cg, -1);
+    char* query = strcmp(cg, "/") == 0 ? g_strdup("") : g_strdup_printf("cg:%s", cg);
+    gtk_entry_set_text(GTK_ENTRY(search_entry), query);
+    gtk_stack_set_visible_child_name(GTK_STACK(main_stack), "process");
+    g_free(query);
+    g_free(cg);
+}
+
+GtkWidget* create_cgroup_panel()
+{
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+
+    cgroup_label = gtk_label_new("正在读取 cgroup...");
+    gtk_widget_set_halign(cgroup_label, GTK_ALIGN_START);
+    gtk_widget_set_margin_start(cgroup_label, 5);
+    gtk_box_pack_start(GTK_BOX(panel), cgroup_label, FALSE, FALSE, 5);
+
+    cgroup_store = gtk_list_store_new(NUM_CGCOLS,
+        G_TYPE_STRING,
+        G_TYPE_DOUBLE,
+        G_TYPE_DOUBLE,
+        G_TYPE_DOUBLE,
+        G_TYPE_DOUBLE,
+        G_TYPE_DOUBLE,
+        G_TYPE_DOUBLE,
+        G_TYPE_INT);
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(cgroup_store), CGCOL_CPU, GTK_SORT_DESCENDING);
+    cgroup_tree_view = gtk_tree_view_new_with_model(GTK_TREE_MODEL(cgroup_store));
+
+    const char* titles[NUM_CGCOLS] = { "cgroup", "CPU%", "内存 MB", "匿名 MB", "文件 MB", "读 KB/s", "写 KB/s", "任务数" };
+    for (int i = 0; i < NUM_CGCOLS; i++) {
+        GtkTreeViewColumn* col = gtk_tree_view_column_new_with_attributes(titles[i],
+            gtk_cell_renderer_text_new(), "text", i, NULL);
+        gtk_tree_view_column_set_sort_column_id(col, i);
+        gtk_tree_view_column_set_resizable(col, TRUE);
+        gtk_tree_view_append_column(GTK_TREE_VIEW(cgroup_tree_view), col);
+    }
+    g_signal_connect(cgroup_tree_view, "row-activated", G_CALLBACK(on_cgroup_row_activated), NULL);
+    g_signal_connect(gtk_tree_view_get_selection(GTK_TREE_VIEW(cgroup_tree_view)), "changed",
+        G_CALLBACK(on_cgroup_selection_changed), NULL);
+
+    GtkWidget* scroll = gtk_scrolled_window_new(NULL, NULL);
+    gtk_container_add(GTK_CONTAINER(scroll), cgroup_tree_view);
+    gtk_box_pack_start(GTK_BOX(panel), scroll, TRUE, TRUE, 0);
+
+    cgroup_psi_label = gtk_label_new("");
+    gtk_widget_set_halign(cgroup_psi_label, GTK_ALIGN_START);
+    gtk_widget_set_margin_start(cgroup_psi_label, 5);
+    gtk_box_pack_start(GTK_BOX(panel), cgroup_psi_label, FALSE, FALSE, 5);
+
+    return panel;
+}
+
+//性能面板
+GtkWidget* create_cpu_panel()
+{
+    /* 最外层：垂直布局 */
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(panel, 10);
+    gtk_widget_set_margin_end(panel, 10);
+    gtk_widget_set_margin_top(panel, 10);
+    gtk_widget_set_margin_bottom(panel, 10);
+
+    /* ────────────── 1️⃣ 顶部概要区 ────────────── */
+    GtkWidget* header_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(panel), header_box, FALSE, FALSE, 0);
+
+    /* CPU 标题 */
+    GtkWidget* title = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(title), "<span size='xx-large' weight='bold'>CPU</span>");
+    gtk_widget_set_halign(title, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(header_box), title, FALSE, FALSE, 0);
+
+    ///* CPU 使用率 + 频率 */
+    //perf_cpu_label = gtk_label_new("0%   0.00 GHz");
+    //gtk_widget_set_halign(perf_cpu_label, GTK_ALIGN_END);
+    //gtk_widget_set_hexpand(perf_cpu_label, TRUE);
+    //gtk_box_pack_end(GTK_BOX(header_box),perf_cpu_label, FALSE, FALSE, 0);
+
+    /* 分隔线 */
+    gtk_box_pack_start(GTK_BOX(panel),gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), FALSE, FALSE, 5);
+
+    /* ────────────── 2️⃣ 折线图区域 ────────────── */
+    cpu_drawing_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(cpu_drawing_area, -1, 260);
+    gtk_box_pack_start(GTK_BOX(panel),
+        cpu_drawing_area, TRUE, TRUE, 0);
+
+    g_signal_connect(cpu_drawing_area, "draw",
+        G_CALLBACK(draw_performance),
+        GINT_TO_POINTER(PERF_CPU));
+
+    /* 每核网格 */
+    cpu_core_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(cpu_core_area, -1, 160);
+    gtk_box_pack_start(GTK_BOX(panel), cpu_core_area, FALSE, FALSE, 0);
+    g_signal_connect(cpu_core_area, "draw", G_CALLBACK(draw_core_grid), NULL);
+
+    /* 分隔线 */
+    gtk_box_pack_start(GTK_BOX(panel),
+        gtk_separator_new(GTK_ORIENTATION_HORIZONTAL),
+        FALSE, FALSE, 5);
+
+    /* ────────────── 3️⃣ 详细信息区 ────────────── */
+    GtkWidget* detail_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
+    gtk_box_pack_start(GTK_BOX(panel), detail_box, FALSE, FALSE, 0);
+
+    GtkWidget* info = create_cpu_info_label(detail_box); gtk_box_pack_start(GTK_BOX(detail_box),info, FALSE, FALSE, 0);
+
+    cpu_split_label = gtk_label_new("用户: 0% | 系统: 0% | IO 等待: 0% | 中断: 0% | 窃取: 0%");
+    gtk_widget_set_halign(cpu_split_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(detail_box), cpu_split_label, FALSE, FALSE, 0);
+
+    return panel;
+}
+
+GtkWidget* create_memory_panel()
+{
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(panel, 10);
+    gtk_widget_set_margin_end(panel, 10);
+    gtk_widget_set_margin_top(panel, 10);
+    gtk_widget_set_margin_bottom(panel, 10);
+
+    /* 顶部 */
+    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(panel), header, FALSE, FALSE, 0);
+
+    GtkWidget* title = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(title),
+        "<span size='x-large' weight='bold'>内存</span>");
+    gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+
+    perf_mem_label = gtk_label_new("0%   0 / 0 GB");
+    gtk_widget_set_halign(perf_mem_label, GTK_ALIGN_END);
+    gtk_box_pack_end(GTK_BOX(header), perf_mem_label, FALSE, FALSE, 0);
+
+    /* 折线图 */
+    mem_drawing_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(mem_drawing_area, -1, 360);
+    gtk_box_pack_start(GTK_BOX(panel),
+        mem_drawing_area, TRUE, TRUE, 0);
+
+    g_signal_connect(mem_drawing_area, "draw",
+        G_CALLBACK(draw_performance), GINT_TO_POINTER(PERF_MEM));
+
+    /* 详细信息 */
+    mem_info_label = gtk_label_new("已用内存:\n可用内存:\n缓存:\n交换空间:");
+    gtk_widget_set_halign(mem_info_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(panel), mem_info_label, FALSE, FALSE, 0);
+
+    return panel;
+}
+
+GtkWidget* create_disk_panel()
+{
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(panel, 10);
+    gtk_widget_set_margin_end(panel, 10);
+    gtk_widget_set_margin_top(panel, 10);
+    gtk_widget_set_margin_bottom(panel, 10);
+
+    /* 顶部 */
+    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(panel), header, FALSE, FALSE, 0);
+
+    GtkWidget* title = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(title),"<span size='x-large' weight='bold'>磁盘</span>");
+    gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+
+    perf_disk_label = gtk_label_new("0 KB/s");
+    gtk_widget_set_halign(perf_disk_label, GTK_ALIGN_END);
+    gtk_box_pack_end(GTK_BOX(header), perf_disk_label, FALSE, FALSE, 0);
+
+    disk_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(disk_combo), "全部磁盘");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(disk_combo), 0);
+    g_signal_connect(disk_combo, "changed", G_CALLBACK(on_disk_device_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(header), disk_combo, FALSE, FALSE, 10);
+
+    /* 折线图 */
+    disk_drawing_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(disk_drawing_area, -1, 360);
+    gtk_box_pack_start(GTK_BOX(panel),disk_drawing_area, TRUE, TRUE, 0);
+
+    g_signal_connect(disk_drawing_area, "draw",G_CALLBACK(draw_performance), GINT_TO_POINTER(PERF_DISK));
+
+    /* 详细信息 */
+    GtkWidget* info_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_box_pack_start(GTK_BOX(panel), info_box, FALSE, FALSE, 0);
+
+    disk_read_label = gtk_label_new("读取: 0 KB/s");
+    disk_write_label = gtk_label_new("写入: 0 KB/s");
+    disk_active_label = gtk_label_new("活动时间: 0 %");
+
+    gtk_widget_set_halign(disk_read_label, GTK_ALIGN_START);
+    gtk_widget_set_halign(disk_write_label, GTK_ALIGN_START);
+    gtk_widget_set_halign(disk_active_label, GTK_ALIGN_START);
+
+    gtk_box_pack_start(GTK_BOX(info_box), disk_read_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(info_box), disk_write_label, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(info_box), disk_active_label, FALSE, FALSE, 0);
+
+    return panel;
+}
+
+GtkWidget* create_psi_panel()
+{
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_widget_set_margin_start(panel, 10);
+    gtk_widget_set_margin_end(panel, 10);
+    gtk_widget_set_margin_top(panel, 10);
+    gtk_widget_set_margin_bottom(panel, 10);
+
+    /* 顶部 */
+    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(panel), header, FALSE, FALSE, 0);
+
+    GtkWidget* title = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(title), "<span size='x-large' weight='bold'>压力 (PSI)</span>");
+    gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+
+    perf_psi_label = gtk_label_new("");
+    gtk_widget_set_halign(perf_psi_label, GTK_ALIGN_END);
+    gtk_box_pack_end(GTK_BOX(header), perf_psi_label, FALSE, FALSE, 0);
+
+    /* 每种资源一行说明加一张图，图上是每轮 some 停顿时间占比 */
+    for (int i = 0; i < PSI_RES; i++) {
+        psi_info_label[i] = gtk_label_new(psi_titles[i]);
+        gtk_widget_set_halign(psi_info_label[i], GTK_ALIGN_START);
+        gtk_box_pack_start(GTK_BOX(panel), psi_info_label[i], FALSE, FALSE, 0);
+
+        psi_drawing_area[i] = gtk_drawing_area_new();
+        gtk_widget_set_size_request(psi_drawing_area[i], -1, 110);
+        gtk_box_pack_start(GTK_BOX(panel), psi_drawing_area[i], TRUE, TRUE, 0);
+        g_signal_connect(psi_drawing_area[i], "draw",
+            G_CALLBACK(draw_performance), GINT_TO_POINTER(PERF_PSI_CPU + i));
+    }
+
+    return panel;
+}
+
+GtkWidget* create_net_panel()
+{
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_widget_set_margin_start(panel, 10);
+    gtk_widget_set_margin_end(panel, 10);
+    gtk_widget_set_margin_top(panel, 10);
+    gtk_widget_set_margin_bottom(panel, 10);
+
+    /* 顶部 */
+    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(panel), header, FALSE, FALSE, 0);
+
+    GtkWidget* title = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(title), "<span size='x-large' weight='bold'>网络</span>");
+    gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+
+    perf_net_label = gtk_label_new("0 KB/s");
+    gtk_widget_set_halign(perf_net_label, GTK_ALIGN_END);
+    gtk_box_pack_end(GTK_BOX(header), perf_net_label, FALSE, FALSE, 0);
+
+    /* 收发合计折线图 */
+    net_drawing_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(net_drawing_area, -1, 200);
+    gtk_box_pack_start(GTK_BOX(panel), net_drawing_area, TRUE, TRUE, 0);
+    g_signal_connect(net_drawing_area, "draw",
+        G_CALLBACK(draw_performance), GINT_TO_POINTER(PERF_NET));
+
+    net_tcp_label = gtk_label_new("TCP:");
+    gtk_widget_set_halign(net_tcp_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(panel), net_tcp_label, FALSE, FALSE, 0);
+
+    /* 每个接口一行，蓝色为接收，橙色为发送 */
+    GtkWidget* scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+        GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scrolled, -1, 180);
+    gtk_box_pack_start(GTK_BOX(panel), scrolled, TRUE, TRUE, 0);
+
+    net_iface_area = gtk_drawing_area_new();
+    gtk_widget_set_size_request(net_iface_area, -1, NET_ROW_H);
+    gtk_container_add(GTK_CONTAINER(scrolled), net_iface_area);
+    g_signal_connect(net_iface_area, "draw", G_CALLBACK(draw_net_iface_rows), NULL);
+
+    return panel;
+}
+
+GtkWidget* create_performance_panel()
+{
+    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+
+    /* ===== 左侧列表 ===== */
+    GtkWidget* list = gtk_list_box_new();
+    gtk_widget_set_size_request(list, 180, -1);
+    gtk_list_box_set_selection_mode(GTK_LIST_BOX(list),
+        GTK_SELECTION_SINGLE);
+    gtk_box_pack_start(GTK_BOX(panel), list, FALSE, FALSE, 0);
+
+    // 压力页的三张图共用一项，用 PERF_PSI_CPU 代表
+    const char* items[] = { "CPU", "内存", "磁盘", "压力", "网络" };
+    const PerfType item_types[] = { PERF_CPU, PERF_MEM, PERF_DISK, PERF_PSI_CPU, PERF_NET };
+    for (int i = 0; i < (int)G_N_ELEMENTS(items); i++) {
+        GtkWidget* row = gtk_list_box_row_new();
+        GtkWidget* label = gtk_label_new(items[i]);
+        gtk_widget_set_margin_start(label, 10);
+        gtk_widget_set_margin_top(label, 8);
+        gtk_widget_set_margin_bottom(label, 8);
+        gtk_container_add(GTK_CONTAINER(row), label);
+        g_object_set_data(G_OBJECT(row), "perf_type",
+            GINT_TO_POINTER(item_types[i]));
+        gtk_list_box_insert(GTK_LIST_BOX(list), row, -1);
+    }
+
+    /* ===== 右侧：缩放选择 + Stack ===== */
+    GtkWidget* right = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_box_pack_start(GTK_BOX(panel), right, TRUE, TRUE, 0);
+
+    GtkWidget* zoom_bar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_widget_set_margin_start(zoom_bar, 10);
+    gtk_widget_set_margin_end(zoom_bar, 10);
+    gtk_widget_set_margin_top(zoom_bar, 5);
+    gtk_box_pack_start(GTK_BOX(right), zoom_bar, FALSE, FALSE, 0);
+
+    GtkWidget* zoom_combo = gtk_combo_box_text_new();
+    for (int i = 0; i < (int)G_N_ELEMENTS(zoom_levels); i++)
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(zoom_combo), zoom_levels[i].label);
+    gtk_combo_box_set_active(GTK_COMBO_BOX(zoom_combo), perf_zoom);
+    g_signal_connect(zoom_combo, "changed", G_CALLBACK(on_zoom_changed), NULL);
+    gtk_box_pack_start(GTK_BOX(zoom_bar), gtk_label_new("时间范围："), FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(zoom_bar), zoom_combo, FALSE, FALSE, 0);
+
+    char buf[64];
+    snprintf(buf, sizeof(buf), "历史数据占用 %.1f MB", perf_history_bytes() / 1024.0 / 1024.0);
+    history_mem_label = gtk_label_new(buf);
+    gtk_box_pack_end(GTK_BOX(zoom_bar), history_mem_label, FALSE, FALSE, 0);
+
+    sample_jitter_label = gtk_label_new("");
+    gtk_box_pack_end(GTK_BOX(zoom_bar), sample_jitter_label, FALSE, FALSE, 10);
+
+    perf_stack = gtk_stack_new();
+    gtk_stack_set_transition_type(GTK_STACK(perf_stack), GTK_STACK_TRANSITION_TYPE_NONE);
+    gtk_box_pack_start(GTK_BOX(right),perf_stack, TRUE, TRUE, 0);
+
+    gtk_stack_add_named(GTK_STACK(perf_stack),
+        create_cpu_panel(), "cpu");
+    gtk_stack_add_named(GTK_STACK(perf_stack),
+        create_memory_panel(), "mem");
+    gtk_stack_add_named(GTK_STACK(perf_stack),
+        create_disk_panel(), "disk");
+    gtk_stack_add_named(GTK_STACK(perf_stack),
+        create_psi_panel(), "psi");
+    gtk_stack_add_named(GTK_STACK(perf_stack),
+        create_net_panel(), "net");
+
+    gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "cpu");
+    gtk_list_box_select_row(GTK_LIST_BOX(list),
+        gtk_list_box_get_row_at_index(GTK_LIST_BOX(list), 0));
+
+    g_signal_connect(list, "row-selected",
+        G_CALLBACK(on_perf_row_selected), NULL);
+
+    return panel;
+}
+
+/* ================= 解析器基准 ================= */
+// monitor --bench-parsers：在录制的样本上对比手写解析器和原来的 sscanf 实现
+
+static const char bench_meminfo[] =
+    "MemTotal:        6158152 kB\n"
+    "MemFree:         5221444 kB\n"
+    "MemAvailable:    5671368 kB\n"
+    "Buffers:           56256 kB\n"
+    "Cached:           600520 kB\n"
+    "SwapCached:            0 kB\n"
+    "Active:           165052 kB\n"
+    "Inactive:         696688 kB\n"
+    "Active(anon):         20 kB\n"
+    "Inactive(anon):   214236 kB\n"
+    "Active(file):     165032 kB\n"
+    "Inactive(file):   482452 kB\n"
+    "Unevictable:       13468 kB\n"
+    "Mlocked:           13476 kB\n"
+    "SwapTotal:             0 kB\n"
+    "SwapFree:              0 kB\n"
+    "Zswap:                 0 kB\n"
+    "Zswapped:              0 kB\n"
+    "Dirty:                92 kB\n"
+    "Writeback:             0 kB\n"
+    "AnonPages:        218468 kB\n"
+    "Mapped:           149860 kB\n"
+    "Shmem:              9288 kB\n"
+    "KReclaimable:      14980 kB\n"
+    "Slab:              31232 kB\n"
+    "SReclaimable:      14980 kB\n"
+    "SUnreclaim:        16252 kB\n"
+    "KernelStack:        1136 kB\n"
+    "PageTables:         1948 kB\n"
+    "SecPageTables:         0 kB\n"
+    "NFS_Unstable:          0 kB\n"
+    "Bounce:                0 kB\n"
+    "WritebackTmp:          0 kB\n"
+    "CommitLimit:     3079076 kB\n"
+    "Committed_AS:     373868 kB\n"
+    "VmallocTotal:   34359738367 kB\n"
+    "VmallocUsed:       15896 kB\n"
+    "VmallocChunk:          0 kB\n"
+    "Percpu:              296 kB\n"
+    "AnonHugePages:         0 kB\n"
+    "ShmemHugePages:        0 kB\n"
+    "ShmemPmdMapped:        0 kB\n"
+    "FileHugePages:         0 kB\n"
+    "FilePmdMapped:         0 kB\n"
+    "Balloon:               0 kB\n"
+    "HugePages_Total:       0\n"
+    "HugePages_Free:        0\n"
+    "HugePages_Rsvd:        0\n"
+    "HugePages_Surp:        0\n"
+    "Hugepagesize:       2048 kB\n"
+    "Hugetlb:               0 kB\n"
+    "DirectMap4k:       26624 kB\n"
+    "DirectMap2M:     2070528 kB\n"
+    "DirectMap1G:     6291456 kB\n";
+
+static const char bench_diskstats[] =
+    "   7       0 loop0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+    "   7       1 loop1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+    "   7       2 loop2 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+    "   8       0 sda 218913 70120 15063514 93510 347101 290366 21826250 474384 0 231528 601552 0 0 0 0 33713 33657\n"
+    "   8       1 sda1 218641 70120 15053922 93449 347101 290366 21826250 474384 0 231500 567834 0 0 0 0 0 0\n"
+    " 259       0 nvme0n1 7754121 1632 619432042 1543871 11398474 2213120 1114262848 10922873 0 4521832 12600452 0 0 0 0 912347 133707\n";
+
+static const char bench_proc_stat[] =
+    "cpu  3167 0 922 51525 101 0 1 554 0 0\n"
+    "cpu0 1584 0 461 25762 50 0 1 277 0 0\n";
+
+static const char bench_pid_stat[] =
+    "1234 (gnome-shell) S 1 1234 1234 0 -1 4194560 1175315 2391 1037 3 284812 61274 2 9 20 0 23 0 5271 5184385024 95013 18446744073709551615 1 1 0 0 0 0 0 4096 83196 0 0 0 17 3 0 0 0 0 0 0 0 0 0 0 0 0 0\n";
+
+static const char bench_pid_io[] =
+    "rchar: 1948271735\n"
+    "wchar: 98234151\n"
+    "syscr: 1923813\n"
+    "syscw: 392818\n"
+    "read_bytes: 412213248\n"
+    "write_bytes: 78983168\n"
+    "cancelled_write_bytes: 2203648\n";
+
+// 逐行取出，等同于原实现中的 fgets
+static const char* legacy_getline(const char* p, char* line, size_t size)
+{
+    if (!p || !*p) return NULL;
+    size_t n = strcspn(p, "\n");
+    size_t c = n < size - 1 ? n : size - 1;
+    memcpy(line, p, c);
+    line[c] = '\0';
+    return p[n] ? p + n + 1 : p + n;
+}
+
+static void legacy_meminfo(const char* buf, MemStat* m)
+{
+    char line[128], key[64], unit[32];
+    long long value;
+
+    memset(m, 0, sizeof(MemStat));
+    while ((buf = legacy_getline(buf, line, sizeof(line))))
+    {
+        if (sscanf(line, "%63s %lld %31s", key, &value, unit) != 3) continue;
+        if (strcmp(key, "MemTotal:") == 0) m->mem_total = value;
+        else if (strcmp(key, "MemFree:") == 0) m->mem_free = value;
+        else if (strcmp(key, "MemAvailable:") == 0) m->mem_available = value;
+        else if (strcmp(key, "Buffers:") == 0) m->buffers = value;
+        else if (strcmp(key, "Cached:") == 0) m->cached = value;
+        else if (strcmp(key, "SwapTotal:") == 0) m->swap_total = value;
+        else if (strcmp(key, "SwapFree:") == 0) m->swap_free = value;
+        else if (strcmp(key, "Active:") == 0) m->active = value;
+        else if (strcmp(key, "Inactive:") == 0) m->inactive = value;
+        else if (strcmp(key, "Slab:") == 0) m->slab = value;
+        else if (strcmp(key, "Shmem:") == 0) m->shmem = value;
+        else if (strcmp(key, "SReclaimable:") == 0) m->sreclaimable = value;
+        else if (strcmp(key, "SUnreclaim:") == 0) m->sunreclaim = value;
+    }
+}
+
+static long long legacy_diskstats(const char* buf)
+{
+    char line[256];
+    long long sectors = 0;
+    while ((buf = legacy_getline(buf, line, sizeof(line))))
+    {
+        int major = 0, minor = 0;
+        char name[32] = { 0 };
+        long long tmp1, tmp2, rd_sectors, tmp4, tmp5, tmp6, wr_sectors, tmp8;
+        if (sscanf(line, "%d %d %31s %lld %lld %lld %lld %lld %lld %lld %lld",
+            &major, &minor, name, &tmp1, &tmp2, &rd_sectors, &tmp4,
+            &tmp5, &tmp6, &wr_sectors, &tmp8) != 11)
+            continue;
+        if (strncmp(name, "sd", 2) == 0 || strncmp(name, "nvme", 4) == 0)
+            sectors += rd_sectors + wr_sectors;
+    }
+    return sectors;
+}
+
+static CpuTotal legacy_cpu_total(const char* buf)
+{
+    CpuTotal c = { 0 };
+    long long user, nice, sys, idle, iowait, irq, softirq, steal;
+    int n = sscanf(buf, "cpu %lld %lld %lld %lld %lld %lld %lld %lld",
+        &user, &nice, &sys, &idle, &iowait, &irq, &softirq, &steal);
+    if (n >= 7) {
+        c.idle = idle + (n > 4 ? iowait : 0);
+        c.total = user + nice + sys + c.idle + (n > 5 ? irq : 0) + (n > 6 ? softirq : 0) + (n > 7 ? steal : 0);
+    }
+    return c;
+}
+
+static void legacy_pid_stat(const char* buf, ProcStat* ps)
+{
+    sscanf(buf, "%*d %127s %c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lld %lld %*d %*d %*d %*d %*d %*d %llu %*u %lld",
+        ps->name, &ps->state, &ps->ppid, &ps->utime, &ps->stime, &ps->starttime, &ps->rss_pages);
+}
+
+static void legacy_pid_io(const char* buf, ProcIO* io)
+{
+    char line[128];
+    io->read_bytes = io->write_bytes = 0;
+    while ((buf = legacy_getline(buf, line, sizeof(line))))
+    {
+        long long tmp;
+        if (sscanf(line, "read_bytes: %lld", &tmp) == 1) io->read_bytes = tmp;
+        if (sscanf(line, "write_bytes: %lld", &tmp) == 1) io->write_bytes = tmp;
+    }
+}
+
+static long long bench_disk_sectors(const char* buf)
+{
+    DiskLine dl;
+    long long sectors = 0;
+    for (const char* p = buf; p && *p; p = next_line(p))
+        if (parse_diskstats_line(p, &dl) && (strncmp(dl.name, "sd", 2) == 0 || strncmp(dl.name, "nvme", 4) == 0))
+            sectors += dl.v[2] + dl.v[6];
+    return sectors;
+}
+
+#define BENCH_ITERS 200000
+
+#define BENCH_RUN(label, expr) do { \
+    gint64 t0 = g_get_monotonic_time(); \
+    for (int it = 0; it < BENCH_ITERS; it++) { expr; } \
+    gint64 t1 = g_get_monotonic_time(); \
+    printf("  %-10s %8.1f ns/op\n", label, (t1 - t0) * 1000.0 / BENCH_ITERS); \
+} while (0)
+
+int bench_parsers()
+{
+    MemStat m1, m2;
+    ProcStat s1, s2;
+    ProcIO i1, i2;
+    volatile long long sink = 0;
+
+    // 先确认两种实现结果一致
+    parse_meminfo(bench_meminfo, &m1);
+    legacy_meminfo(bench_meminfo, &m2);
+    parse_proc_stat(bench_pid_stat, &s1);
+    legacy_pid_stat(bench_pid_stat, &s2);
+    parse_proc_io(bench_pid_io, &i1);
+    legacy_pid_io(bench_pid_io, &i2);
+    if (memcmp(&m1, &m2, sizeof(MemStat)) != 0 ||
+        s1.utime != s2.utime || s1.stime != s2.stime || s1.starttime != s2.starttime || s1.rss_pages != s2.rss_pages ||
+        i1.read_bytes != i2.read_bytes || i1.write_bytes != i2.write_bytes ||
+        bench_disk_sectors(bench_diskstats) != legacy_diskstats(bench_diskstats) ||
+        parse_cpu_total(bench_proc_stat).total != legacy_cpu_total(bench_proc_stat).total) {
+        fprintf(stderr, "parser mismatch\n");
+        return 1;
+    }
+
+    printf("meminfo\n");
+    BENCH_RUN("sscanf", legacy_meminfo(bench_meminfo, &m2); sink += m2.mem_total);
+    BENCH_RUN("parser", parse_meminfo(bench_meminfo, &m1); sink += m1.mem_total);
+
+    printf("diskstats\n");
+    BENCH_RUN("sscanf", sink += legacy_diskstats(bench_diskstats));
+    BENCH_RUN("parser", sink += bench_disk_sectors(bench_diskstats));
+
+    printf("/proc/stat cpu\n");
+    BENCH_RUN("sscanf", sink += legacy_cpu_total(bench_proc_stat).total);
+    BENCH_RUN("parser", sink += parse_cpu_total(bench_proc_stat).total);
+
+    printf("/proc/PID/stat\n");
+    BENCH_RUN("sscanf", legacy_pid_stat(bench_pid_stat, &s2); sink += s2.utime);
+    BENCH_RUN("parser", parse_proc_stat(bench_pid_stat, &s1); sink += s1.utime);
 
-    GtkWidget* search_label = gtk_label_new("搜索：");
-    search_entry = gtk_entry_new();
-    gtk_box_pack_start(GTK_BOX(bottom_box), search_label, FALSE, FALSE, 0);
-    gtk_box_pack_start(GTK_BOX(bottom_box), search_entry, TRUE, TRUE, 0);
-    g_signal_connect(search_entry, "changed", G_CALLBACK(on_search_changed), NULL);
+    printf("/proc/PID/io\n");
+    BENCH_RUN("sscanf", legacy_pid_io(bench_pid_io, &i2); sink += i2.read_bytes);
+    BENCH_RUN("parser", parse_proc_io(bench_pid_io, &i1); sink += i1.read_bytes);
 
-    GtkWidget* kill_btn = gtk_button_new_with_label("结束任务");
-    g_signal_connect(kill_btn, "clicked", G_CALLBACK(on_kill_task_clicked), NULL);
-    gtk_box_pack_end(GTK_BOX(bottom_box), kill_btn, FALSE, FALSE, 0);
+    return 0;
+}
 
-    gtk_box_pack_start(GTK_BOX(process_panel_box), bottom_box, FALSE, FALSE, 5);
+/* ================= 扫描基准 ================= */
+// monitor --bench-scan：在当前系统上用不同的 worker 数扫描 /proc，报告扫描耗时
+#define BENCH_SCAN_TICKS 10
 
-    // ------------------ 列标题及渲染器 ------------------
-    const char* titles[NUM_COLS] = { "PID", "Name", "CPU%", "MEM%", "Disk KB/s" };
-    for (int i = 0; i < NUM_COLS; i++) {
-        GtkTreeViewColumn* col = gtk_tree_view_column_new();
-        gtk_tree_view_column_set_title(col, titles[i]);
-        renderers[i] = GTK_CELL_RENDERER_TEXT(gtk_cell_renderer_text_new());
-        gtk_tree_view_column_pack_start(col, GTK_CELL_RENDERER(renderers[i]), TRUE);
-        gtk_tree_view_column_add_attribute(col, GTK_CELL_RENDERER(renderers[i]), "text", i);
-        gtk_tree_view_append_column(GTK_TREE_VIEW(process_tree_view), col);
+int bench_scan()
+{
+    int ncpu = g_get_num_processors();
+    proc_scan_init(ncpu);
+    scan_inline_pids = 0;
+
+    printf("workers  scan ms (avg of %d ticks)\n", BENCH_SCAN_TICKS);
+    for (int w = 1; ; w *= 2) {
+        if (w > ncpu) w = ncpu;
+        proc_scan_set_workers(w);
+
+        gint64 total = 0;
+        guint npids = 0;
+        for (int t = 0; t <= BENCH_SCAN_TICKS; t++) {
+            Snapshot* s = g_new0(Snapshot, 1);
+            collect_system(&s->sys);
+            collect_process_rows(s);
+            if (t > 0) total += s->scan_us;    // 第一轮用于预热 fd 缓存
+            npids = s->procs->len;
+            snapshot_free(s);
+        }
+        printf("%7d  %8.2f  (%u pids)\n", w, total / 1000.0 / BENCH_SCAN_TICKS, npids);
 
-        g_object_set_data(G_OBJECT(col), "col_index", GINT_TO_POINTER(i));
-        g_signal_connect(col, "clicked", G_CALLBACK(column_clicked), NULL);
-        gtk_tree_view_column_set_sort_column_id(col, i);
+        if (w == ncpu) break;
     }
+    return 0;
+}
 
-    g_signal_connect(process_tree_view, "cursor-changed", G_CALLBACK(on_row_selected), NULL);
+/* ================= 界面基准 ================= */
+// monitor --bench-ui FILE：用录制文件直接驱动进程列表和性能图，不经过采集线程和计时器。
+// 每条记录依次测量进程列表模型更新、过滤、整表排序和各张图的 cairo 绘制，
+// 结果只取决于录制内容，可以用来对比界面改动前后的耗时
+#define BENCH_UI_PASSES 3
+#define BENCH_UI_WIDTH 800
+#define BENCH_UI_HEIGHT 300
 
-    g_timeout_add_seconds(flash_time, update_process_list, NULL);
-    g_timeout_add_seconds(flash_time, update_system_summary, sys_label);
+static int compare_gint64(const void* a, const void* b)
+{
+    gint64 x = *(const gint64*)a, y = *(const gint64*)b;
+    return (x > y) - (x < y);
+}
 
-    return process_panel_box;
+static void bench_ui_report(const char* label, GArray* samples)
+{
+    gint64* v = (gint64*)samples->data;
+    guint n = samples->len;
+    qsort(v, n, sizeof(gint64), compare_gint64);
+
+    gint64 total = 0;
+    for (guint i = 0; i < n; i++) total += v[i];
+    printf("  %-8s avg %8.3f  p50 %8.3f  p99 %8.3f ms\n", label,
+        total / 1000.0 / n, v[n / 2] / 1000.0, v[(n - 1) * 99 / 100] / 1000.0);
 }
 
-//性能面板
-GtkWidget* create_cpu_panel()
+int bench_ui(const char* path)
 {
-    /* 最外层：垂直布局 */
-    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_widget_set_margin_start(panel, 10);
-    gtk_widget_set_margin_end(panel, 10);
-    gtk_widget_set_margin_top(panel, 10);
-    gtk_widget_set_margin_bottom(panel, 10);
+    if (!gtk_init_check(NULL, NULL)) {
+        g_printerr("界面基准需要图形环境\n");
+        return 1;
+    }
+    ReplaySource* r = replay_open(path, 1);
+    if (!r) return 1;
+
+    perf_history_init(&perf_history);
+    create_process_panel();
+    create_performance_panel();
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(proc_model), COL_CPU, GTK_SORT_DESCENDING);
+    search_set_query("s");   // 固定的过滤条件
+
+    cairo_surface_t* surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, BENCH_UI_WIDTH, BENCH_UI_HEIGHT);
+    cairo_t* cr = cairo_create(surface);
+
+    const char* labels[] = { "list", "filter", "sort", "draw" };
+    GArray* samples[4];
+    for (int k = 0; k < 4; k++)
+        samples[k] = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+    for (int pass = 0; pass < BENCH_UI_PASSES; pass++) {
+        // 每一遍都从空列表和空历史开始
+        process_view_refresh(proc_model_clear(proc_model));
+        perf_history_reset(&perf_history);
+
+        for (guint i = 0; i < r->records->len; i++) {
+            Snapshot* s = replay_build(r, i);
+            gint64 t[5];
+
+            t[0] = g_get_monotonic_time();
+            update_process_list(s);
+            update_system_summary(s);
+            update_system_total(s);
+            update_cpu_detail_label(s);
+            update_cpu_cores(s);
+            update_memory_info(s);
+            update_disk_info(s);
+            t[1] = g_get_monotonic_time();
+            process_view_refresh(proc_model_refilter(proc_model));
+            t[2] = g_get_monotonic_time();
+            gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(proc_model),
+                GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_DESCENDING);
+            gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(proc_model), COL_CPU, GTK_SORT_DESCENDING);
+            t[3] = g_get_monotonic_time();
+            for (int type = PERF_CPU; type <= PERF_DISK; type++)
+                draw_perf_graph(cr, BENCH_UI_WIDTH, BENCH_UI_HEIGHT, type);
+            draw_core_cells(cr, BENCH_UI_WIDTH, BENCH_UI_HEIGHT);
+            cairo_surface_flush(surface);
+            t[4] = g_get_monotonic_time();
+
+            for (int k = 0; k < 4; k++) {
+                gint64 dt = t[k + 1] - t[k];
+                g_array_append_val(samples[k], dt);
+            }
+            snapshot_free(s);
+        }
+    }
 
-    /* ────────────── 1️⃣ 顶部概要区 ────────────── */
-    GtkWidget* header_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    gtk_box_pack_start(GTK_BOX(panel), header_box, FALSE, FALSE, 0);
+    printf("%u records x %d passes\n", r->records->len, BENCH_UI_PASSES);
+    for (int k = 0; k < 4; k++) {
+        bench_ui_report(labels[k], samples[k]);
+        g_array_free(samples[k], TRUE);
+    }
 
-    /* CPU 标题 */
-    GtkWidget* title = gtk_label_new(NULL);
-    gtk_label_set_markup(GTK_LABEL(title), "<span size='xx-large' weight='bold'>CPU</span>");
-    gtk_widget_set_halign(title, GTK_ALIGN_START);
-    gtk_box_pack_start(GTK_BOX(header_box), title, FALSE, FALSE, 0);
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    return 0;
+}
 
-    ///* CPU 使用率 + 频率 */
-    //perf_cpu_label = gtk_label_new("0%   0.00 GHz");
-    //gtk_widget_set_halign(perf_cpu_label, GTK_ALIGN_END);
-    //gtk_widget_set_hexpand(perf_cpu_label, TRUE);
-    //gtk_box_pack_end(GTK_BOX(header_box),perf_cpu_label, FALSE, FALSE, 0);
+/* ================= 无界面模式 ================= */
+// monitor --headless：复用同一套采集函数，按间隔把快照以 JSON 行或 CSV 输出，
+// 每轮的输出先拼到缓冲区里，再用一次 write 写出
 
-    /* 分隔线 */
-    gtk_box_pack_start(GTK_BOX(panel),gtk_separator_new(GTK_ORIENTATION_HORIZONTAL), FALSE, FALSE, 5);
+enum {
+    OUT_JSON,
+    OUT_CSV
+};
 
-    /* ────────────── 2️⃣ 折线图区域 ────────────── */
-    cpu_drawing_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(cpu_drawing_area, -1, 260);
-    gtk_box_pack_start(GTK_BOX(panel),
-        cpu_drawing_area, TRUE, TRUE, 0);
+static void append_json_string(GString* out, const char* s)
+{
+    g_string_append_c(out, '"');
+    while (*s) {
+        unsigned char c = *s;
+        if (c >= 0x80) {
+            // 进程名按字节截断，可能断在多字节字符中间；不合法的字节按 \u00XX 输出，保证整行是合法 UTF-8
+            gunichar ch = g_utf8_get_char_validated(s, -1);
+            if (ch == (gunichar)-1 || ch == (gunichar)-2) {
+                g_string_append_printf(out, "\\u%04x", c);
+                s++;
+            }
+            else {
+                const char* next = g_utf8_next_char(s);
+                g_string_append_len(out, s, next - s);
+                s = next;
+            }
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            g_string_append_c(out, '\\');
+            g_string_append_c(out, c);
+        }
+        else if (c < 0x20) {
+            g_string_append_printf(out, "\\u%04x", c);
+        }
+        else {
+            g_string_append_c(out, c);
+        }
+        s++;
+    }
+    g_string_append_c(out, '"');
+}
 
-    g_signal_connect(cpu_drawing_area, "draw",
-        G_CALLBACK(draw_performance),
-        GINT_TO_POINTER(PERF_CPU));
+static void append_csv_string(GString* out, const char* s)
+{
+    if (!strpbrk(s, ",\"\n")) {
+        g_string_append(out, s);
+        return;
+    }
+    g_string_append_c(out, '"');
+    for (; *s; s++) {
+        if (*s == '"') g_string_append_c(out, '"');
+        g_string_append_c(out, *s);
+    }
+    g_string_append_c(out, '"');
+}
 
-    /* 分隔线 */
-    gtk_box_pack_start(GTK_BOX(panel),
-        gtk_separator_new(GTK_ORIENTATION_HORIZONTAL),
-        FALSE, FALSE, 5);
+static int compare_row_cpu_desc(const void* a, const void* b)
+{
+    double va = ((const ProcRow*)a)->cpu, vb = ((const ProcRow*)b)->cpu;
+    return (va < vb) - (va > vb);
+}
 
-    /* ────────────── 3️⃣ 详细信息区 ────────────── */
-    GtkWidget* detail_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
-    gtk_box_pack_start(GTK_BOX(panel), detail_box, FALSE, FALSE, 0);
+void format_snapshot(GString* out, Snapshot* s, int format, int top_n)
+{
+    double ts = s->wall_us / 1e6;
+    const SystemSnapshot* sys = &s->sys;
 
-    GtkWidget* info = create_cpu_info_label(detail_box); gtk_box_pack_start(GTK_BOX(detail_box),info, FALSE, FALSE, 0);
+    guint n = s->procs->len;
+    if (top_n > 0) {
+        g_array_sort(s->procs, compare_row_cpu_desc);
+        n = MIN(n, (guint)top_n);
+    }
 
-    return panel;
+    if (format == OUT_CSV) {
+        g_string_append_printf(out, "%.3f,system,,,%.2f,%.2f,%.2f\n",
+            ts, sys->cpu_p, sys->mem_p, sys->disk_kb);
+        for (guint i = 0; i < n; i++) {
+            const ProcRow* row = &g_array_index(s->procs, ProcRow, i);
+            g_string_append_printf(out, "%.3f,process,%d,", ts, row->pid);
+            append_csv_string(out, row->name);
+            g_string_append_printf(out, ",%.2f,%.2f,%.2f\n", row->cpu, row->mem, row->io_kb);
+        }
+        return;
+    }
+
+    g_string_append_printf(out,
+        "{\"ts\":%.3f,\"elapsed_ms\":%.1f,\"jitter_ms\":%.2f,\"cpu\":%.2f,\"mem\":%.2f,\"disk_kb\":%.2f,"
+        "\"mem_total_kb\":%lld,\"mem_available_kb\":%lld,\"procs\":[",
+        ts, sys->elapsed_s * 1000.0, s->jitter_us / 1000.0, sys->cpu_p, sys->mem_p, sys->disk_kb,
+        sys->mem.mem_total, sys->mem.mem_available);
+    for (guint i = 0; i < n; i++) {
+        const ProcRow* row = &g_array_index(s->procs, ProcRow, i);
+        g_string_append_printf(out, "%s{\"pid\":%d,\"name\":", i ? "," : "", row->pid);
+        append_json_string(out, row->name);
+        g_string_append_printf(out, ",\"cpu\":%.2f,\"mem\":%.2f,\"io_kb\":%.2f}",
+            row->cpu, row->mem, row->io_kb);
+    }
+    g_string_append(out, "]}\n");
 }
 
-GtkWidget* create_memory_panel()
+// 一次 write 写出整块缓冲区，只有被信号打断或部分写入时才会继续
+static int write_all(int fd, const char* buf, size_t len)
 {
-    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_widget_set_margin_start(panel, 10);
-    gtk_widget_set_margin_end(panel, 10);
-    gtk_widget_set_margin_top(panel, 10);
-    gtk_widget_set_margin_bottom(panel, 10);
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        buf += n;
+        len -= n;
+    }
+    return 1;
+}
 
-    /* 顶部 */
-    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    gtk_box_pack_start(GTK_BOX(panel), header, FALSE, FALSE, 0);
+int run_headless(const char* format_name, const char* output, int top_n)
+{
+    int format = OUT_JSON;
+    if (format_name && strcmp(format_name, "csv") == 0)
+        format = OUT_CSV;
+    else if (format_name && strcmp(format_name, "json") != 0) {
+        g_printerr("未知的输出格式: %s（可选 json、csv）\n", format_name);
+        return 1;
+    }
 
-    GtkWidget* title = gtk_label_new(NULL);
-    gtk_label_set_markup(GTK_LABEL(title),
-        "<span size='x-large' weight='bold'>内存</span>");
-    gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+    int fd = STDOUT_FILENO;
+    if (output) {
+        fd = open(output, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            g_printerr("无法打开 %s: %s\n", output, strerror(errno));
+            return 1;
+        }
+    }
 
-    perf_mem_label = gtk_label_new("0%   0 / 0 GB");
-    gtk_widget_set_halign(perf_mem_label, GTK_ALIGN_END);
-    gtk_box_pack_end(GTK_BOX(header), perf_mem_label, FALSE, FALSE, 0);
+    proc_scan_init(scan_workers);
 
-    /* 折线图 */
-    mem_drawing_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(mem_drawing_area, -1, 360);
-    gtk_box_pack_start(GTK_BOX(panel),
-        mem_drawing_area, TRUE, TRUE, 0);
+    GString* out = g_string_sized_new(1 << 16);
+    if (format == OUT_CSV)
+        g_string_append(out, "ts,kind,pid,name,cpu,mem,disk_kb\n");
 
-    g_signal_connect(mem_drawing_area, "draw",
-        G_CALLBACK(draw_performance), GINT_TO_POINTER(PERF_MEM));
+    int ok = 0;
+    for (;;) {
+        Snapshot* s = snapshot_source->next(snapshot_source);
+        if (!s) {
+            ok = 1;     // 回放结束
+            break;
+        }
+        record_snapshot(recorder, s);
+        format_snapshot(out, s, format, top_n);
+        snapshot_free(s);
 
-    /* 详细信息 */
-    mem_info_label = gtk_label_new("已用内存:\n可用内存:\n缓存:\n交换空间:");
-    gtk_widget_set_halign(mem_info_label, GTK_ALIGN_START);
-    gtk_box_pack_start(GTK_BOX(panel), mem_info_label, FALSE, FALSE, 0);
+        if (!write_all(fd, out->str, out->len))
+            break;
+        g_string_truncate(out, 0);
+    }
 
-    return panel;
+    g_string_free(out, TRUE);
+    if (fd != STDOUT_FILENO) close(fd);
+    return ok ? 0 : 1;
 }
 
-GtkWidget* create_disk_panel()
+/* ================= 合成 /proc 基准 ================= */
+// monitor --bench-synth：在临时目录生成 N 个进程的假 /proc（系统文件加每个进程的 stat、status、io），
+// 把 proc_root 指过去，分别测量只采集、采集加进程列表模型更新时每轮的 p50/p99 耗时和分配次数。
+// 每轮改写 5% 进程的 stat 和系统 CPU 计数，让增量更新有真实的变化量。
+// 分配次数需要编译时加 -DMONITOR_COUNT_ALLOCS（单独的基准构建，不用于发布），
+// 普通构建里这一列显示 n/a；100k 进程约占 1.2 GB 临时空间。
+#define SYNTH_TICKS 20
+#define SYNTH_CHURN 20          // 每轮改写 1/20 的进程
+
+#if defined(MONITOR_COUNT_ALLOCS) && defined(__GLIBC__)
+// 包住 glibc 的分配函数计数，GLib 的 g_malloc 最终也会走到这里。
+// 只计数不改变分配行为，free 等其余函数仍由 glibc 处理；不要和 ASan 或 LD_PRELOAD 的分配器一起用
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* p, size_t size);
+static int alloc_counting = 0;
+static guint64 alloc_count = 0;
+
+static inline void alloc_count_add()
 {
-    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-    gtk_widget_set_margin_start(panel, 10);
-    gtk_widget_set_margin_end(panel, 10);
-    gtk_widget_set_margin_top(panel, 10);
-    gtk_widget_set_margin_bottom(panel, 10);
+    if (__atomic_load_n(&alloc_counting, __ATOMIC_RELAXED))
+        __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+}
 
-    /* 顶部 */
-    GtkWidget* header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
-    gtk_box_pack_start(GTK_BOX(panel), header, FALSE, FALSE, 0);
+void* malloc(size_t size)
+{
+    alloc_count_add();
+    return __libc_malloc(size);
+}
 
-    GtkWidget* title = gtk_label_new(NULL);
-    gtk_label_set_markup(GTK_LABEL(title),"<span size='x-large' weight='bold'>磁盘</span>");
-    gtk_box_pack_start(GTK_BOX(header), title, FALSE, FALSE, 0);
+void* calloc(size_t n, size_t size)
+{
+    alloc_count_add();
+    return __libc_calloc(n, size);
+}
 
-    perf_disk_label = gtk_label_new("0 KB/s");
-    gtk_widget_set_halign(perf_disk_label, GTK_ALIGN_END);
-    gtk_box_pack_end(GTK_BOX(header), perf_disk_label, FALSE, FALSE, 0);
+void* realloc(void* p, size_t size)
+{
+    alloc_count_add();
+    return __libc_realloc(p, size);
+}
 
-    /* 折线图 */
-    disk_drawing_area = gtk_drawing_area_new();
-    gtk_widget_set_size_request(disk_drawing_area, -1, 360);
-    gtk_box_pack_start(GTK_BOX(panel),disk_drawing_area, TRUE, TRUE, 0);
+#define ALLOC_COUNT_START() __atomic_store_n(&alloc_counting, 1, __ATOMIC_RELAXED)
+#define ALLOC_COUNT() ((gint64)__atomic_load_n(&alloc_count, __ATOMIC_RELAXED))
+#else
+#define ALLOC_COUNT_START() ((void)0)
+#define ALLOC_COUNT() ((gint64)-1)
+#endif
 
-    g_signal_connect(disk_drawing_area, "draw",G_CALLBACK(draw_performance), GINT_TO_POINTER(PERF_DISK));
+static gboolean opt_bench_synth = FALSE;
+static int synth_procs = 0;     // 只测这一个规模，0 表示依次测 1k、10k、100k
 
-    /* 详细信息 */
-    GtkWidget* info_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
-    gtk_box_pack_start(GTK_BOX(panel), info_box, FALSE, FALSE, 0);
+static const char* synth_names[] = {
+    "bash", "sshd", "postgres", "nginx", "java", "python3",
+    "kworker/0:1", "systemd-journal", "chrome", "node",
+};
 
-    disk_read_label = gtk_label_new("读取速度: 0 KB/s");
-    disk_write_label = gtk_label_new("写入速度: 0 KB/s");
-    disk_active_label = gtk_label_new("活动时间: 0 %");
+static int write_text(const char* path, const char* text)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return 0;
+    int ok = write_all(fd, text, strlen(text));
+    close(fd);
+    return ok;
+}
 
-    gtk_widget_set_halign(disk_read_label, GTK_ALIGN_START);
-    gtk_widget_set_halign(disk_write_label, GTK_ALIGN_START);
-    gtk_widget_set_halign(disk_active_label, GTK_ALIGN_START);
+static void synth_write_pid_stat(const char* root, int pid, int tick)
+{
+    char path[300], buf[512];
+    const char* name = synth_names[pid % G_N_ELEMENTS(synth_names)];
+    long long utime = pid % 1000 + (long long)tick * (pid % 7 + 1) * 5;
+    long long stime = pid % 300 + tick;
 
-    gtk_box_pack_start(GTK_BOX(info_box), disk_read_label, FALSE, FALSE, 0);
-    gtk_box_pack_start(GTK_BOX(info_box), disk_write_label, FALSE, FALSE, 0);
-    gtk_box_pack_start(GTK_BOX(info_box), disk_active_label, FALSE, FALSE, 0);
+    snprintf(path, sizeof(path), "%s/%d/stat", root, pid);
+    snprintf(buf, sizeof(buf),
+        "%d (%s) S 1 %d %d 0 -1 4194560 %d 0 %d 0 %lld %lld 0 0 20 0 %d 0 %d %lld %d "
+        "18446744073709551615 1 1 0 0 0 0 0 4096 0 0 0 0 17 %d 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+        pid, name, pid, pid, pid * 13 % 100000, pid % 50, utime, stime,
+        pid % 16 + 1, 5000 + pid, (long long)(pid % 64 + 1) << 24, pid % 4096 + 200, pid % 8);
+    write_text(path, buf);
+}
 
-    return panel;
+static void synth_write_pid(const char* root, int pid)
+{
+    char path[300], buf[1024];
+    const char* name = synth_names[pid % G_N_ELEMENTS(synth_names)];
+
+    snprintf(path, sizeof(path), "%s/%d", root, pid);
+    mkdir(path, 0755);
+    synth_write_pid_stat(root, pid, 0);
+
+    snprintf(path, sizeof(path), "%s/%d/status", root, pid);
+    int rss = pid % 4096 * 4 + 800;
+    snprintf(buf, sizeof(buf),
+        "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\nTgid:\t%d\nNgid:\t0\nPid:\t%d\nPPid:\t1\n"
+        "TracerPid:\t0\nUid:\t1000\t1000\t1000\t1000\nGid:\t1000\t1000\t1000\t1000\nFDSize:\t64\n"
+        "Groups:\t4 24 27 1000\nVmPeak:\t  %d kB\nVmSize:\t  %d kB\nVmRSS:\t  %d kB\n"
+        "RssAnon:\t  %d kB\nRssFile:\t  %d kB\nThreads:\t%d\n"
+        "voluntary_ctxt_switches:\t%d\nnonvoluntary_ctxt_switches:\t%d\n",
+        name, pid, pid, rss * 8, rss * 6, rss, rss / 2, rss / 2, pid % 16 + 1, pid * 3 % 100000, pid % 500);
+    write_text(path, buf);
+
+    snprintf(path, sizeof(path), "%s/%d/io", root, pid);
+    snprintf(buf, sizeof(buf),
+        "rchar: %d\nwchar: %d\nsyscr: %d\nsyscw: %d\nread_bytes: %d\nwrite_bytes: %d\ncancelled_write_bytes: 0\n",
+        pid * 4096, pid * 512, pid * 3, pid, pid % 1000 * 4096, pid % 100 * 4096);
+    write_text(path, buf);
 }
 
-GtkWidget* create_performance_panel()
+static void synth_write_system(const char* root, int tick)
 {
-    GtkWidget* panel = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    char path[300], buf[256];
+    snprintf(path, sizeof(path), "%s/stat", root);
+    snprintf(buf, sizeof(buf), "cpu  %d 0 %d %d 101 0 1 554 0 0\ncpu0 %d 0 %d %d 50 0 1 277 0 0\n",
+        3167 + tick * 60, 922 + tick * 20, 51525 + tick * 20, 1584 + tick * 60, 461 + tick * 20, 25762 + tick * 20);
+    write_text(path, buf);
+}
 
-    /* ===== 左侧列表 ===== */
-    GtkWidget* list = gtk_list_box_new();
-    gtk_widget_set_size_request(list, 180, -1);
-    gtk_list_box_set_selection_mode(GTK_LIST_BOX(list),
-        GTK_SELECTION_SINGLE);
-    gtk_box_pack_start(GTK_BOX(panel), list, FALSE, FALSE, 0);
+static void remove_tree(const char* path)
+{
+    DIR* dir = opendir(path);
+    if (dir) {
+        struct dirent* d;
+        while ((d = readdir(dir))) {
+            if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0) continue;
+            char* child = g_build_filename(path, d->d_name, NULL);
+            if (d->d_type == DT_DIR) remove_tree(child);
+            else unlink(child);
+            g_free(child);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
 
-    const char* items[] = { "CPU", "内存", "磁盘" };
-    for (int i = 0; i < 3; i++) {
-        GtkWidget* row = gtk_list_box_row_new();
-        GtkWidget* label = gtk_label_new(items[i]);
-        gtk_widget_set_margin_start(label, 10);
-        gtk_widget_set_margin_top(label, 8);
-        gtk_widget_set_margin_bottom(label, 8);
-        gtk_container_add(GTK_CONTAINER(row), label);
-        g_object_set_data(G_OBJECT(row), "perf_type",
-            GINT_TO_POINTER(i));
-        gtk_list_box_insert(GTK_LIST_BOX(list), row, -1);
+// 生成 proc/ 和 sys/ 两棵目录，pid 从 pid_base 开始编号
+static char* synth_create(int n, int pid_base)
+{
+    char* dir = g_dir_make_tmp("monitor-synth-XXXXXX", NULL);
+    if (!dir) return NULL;
+
+    char* proc = g_build_filename(dir, "proc", NULL);
+    char* freq = g_build_filename(dir, "sys/devices/system/cpu/cpu0/cpufreq", NULL);
+    g_mkdir_with_parents(proc, 0755);
+    g_mkdir_with_parents(freq, 0755);
+
+    char path[300];
+    snprintf(path, sizeof(path), "%s/scaling_cur_freq", freq);
+    write_text(path, "2400000\n");
+    snprintf(path, sizeof(path), "%s/meminfo", proc);
+    write_text(path, bench_meminfo);
+    snprintf(path, sizeof(path), "%s/diskstats", proc);
+    write_text(path, bench_diskstats);
+    const char* disks[] = { "sys/block/sda", "sys/block/nvme0n1" };
+    for (int i = 0; i < (int)G_N_ELEMENTS(disks); i++) {
+        char* block = g_build_filename(dir, disks[i], NULL);
+        g_mkdir_with_parents(block, 0755);
+        g_free(block);
     }
+    snprintf(path, sizeof(path), "%s/cpuinfo", proc);
+    write_text(path, "processor\t: 0\nmodel name\t: Synthetic CPU\ncpu MHz\t\t: 2400.000\n"
+        "cache size\t: 16384 KB\ncpu cores\t: 1\n\n");
+    synth_write_system(proc, 0);
 
-    /* ===== 右侧 Stack ===== */
-    perf_stack = gtk_stack_new();
-    gtk_stack_set_transition_type(GTK_STACK(perf_stack), GTK_STACK_TRANSITION_TYPE_NONE);
-    gtk_box_pack_start(GTK_BOX(panel),perf_stack, TRUE, TRUE, 0);
+    for (int i = 0; i < n; i++)
+        synth_write_pid(proc, pid_base + i);
 
-    gtk_stack_add_named(GTK_STACK(perf_stack),
-        create_cpu_panel(), "cpu");
-    gtk_stack_add_named(GTK_STACK(perf_stack),
-        create_memory_panel(), "mem");
-    gtk_stack_add_named(GTK_STACK(perf_stack),
-        create_disk_panel(), "disk");
+    g_free(proc);
+    g_free(freq);
+    return dir;
+}
 
-    gtk_stack_set_visible_child_name(GTK_STACK(perf_stack), "cpu");
-    gtk_list_box_select_row(GTK_LIST_BOX(list),
-        gtk_list_box_get_row_at_index(GTK_LIST_BOX(list), 0));
+static void synth_report(int n, const char* mode, GArray* us, gint64 allocs)
+{
+    gint64* v = (gint64*)us->data;
+    qsort(v, us->len, sizeof(gint64), compare_gint64);
+    double p50 = v[us->len / 2] / 1000.0;
+    double p99 = v[(us->len - 1) * 99 / 100] / 1000.0;
+
+    if (allocs >= 0)
+        printf("%7d  %-14s %9.2f %9.2f %12.1f\n", n, mode, p50, p99, (double)allocs / us->len);
+    else
+        printf("%7d  %-14s %9.2f %9.2f %12s\n", n, mode, p50, p99, "n/a");
+}
 
-    g_signal_connect(list, "row-selected",
-        G_CALLBACK(on_perf_row_selected), NULL);
+// with_model 为真时把 update_process_list 也算进每轮耗时
+static void synth_run(const char* proc, int n, int pid_base, int* tick, int with_model)
+{
+    GArray* us = g_array_new(FALSE, FALSE, sizeof(gint64));
+    gint64 allocs = 0;
+
+    for (int t = 0; t <= SYNTH_TICKS; t++) {
+        int tk = ++*tick;
+        synth_write_system(proc, tk);
+        for (int i = tk % SYNTH_CHURN; i < n; i += SYNTH_CHURN)
+            synth_write_pid_stat(proc, pid_base + i, tk);
+
+        gint64 a0 = ALLOC_COUNT();
+        gint64 t0 = g_get_monotonic_time();
+        Snapshot* s = collect_snapshot();
+        if (with_model) update_process_list(s);
+        gint64 dt = g_get_monotonic_time() - t0;
+        gint64 a1 = ALLOC_COUNT();
+        snapshot_free(s);
+
+        if (t == 0) continue;   // 第一轮建立 fd 缓存和进程列表模型，不计入
+        g_array_append_val(us, dt);
+        allocs += a1 - a0;
+    }
 
-    return panel;
+    synth_report(n, with_model ? "collect+model" : "collect", us, ALLOC_COUNT() >= 0 ? allocs : -1);
+    g_array_free(us, TRUE);
+}
+
+int bench_synth()
+{
+    static const int sizes[] = { 1000, 10000, 100000 };
+    int count = synth_procs > 0 ? 1 : G_N_ELEMENTS(sizes);
+
+    ALLOC_COUNT_START();
+    gtk_init_check(NULL, NULL);     // 进程列表模型不需要显示器，有图形环境时顺便初始化
+    create_process_models();
+    gtk_tree_sortable_set_sort_column_id(GTK_TREE_SORTABLE(proc_model), COL_CPU, GTK_SORT_DESCENDING);
+    proc_scan_init(scan_workers);
+
+    printf("%7s  %-14s %9s %9s %12s   (%d ticks)\n", "procs", "mode", "p50 ms", "p99 ms", "allocs/tick", SYNTH_TICKS);
+    if (ALLOC_COUNT() < 0)
+        printf("(allocs/tick 需要用 -DMONITOR_COUNT_ALLOCS 重新编译)\n");
+    int tick = 0;
+    for (int k = 0; k < count; k++) {
+        int n = synth_procs > 0 ? synth_procs : sizes[k];
+        // 每个规模用不同的 PID 段，避免 fd 缓存拿到上一棵目录里已删除文件的旧 fd
+        int pid_base = 1000 + k * 200000;
+
+        char* dir = synth_create(n, pid_base);
+        if (!dir) {
+            g_printerr("无法创建临时目录\n");
+            return 1;
+        }
+        char* proc = g_build_filename(dir, "proc", NULL);
+        char* sys = g_build_filename(dir, "sys", NULL);
+        g_strlcpy(proc_root, proc, sizeof(proc_root));
+        g_strlcpy(sys_root, sys, sizeof(sys_root));
+        system_files_reset();
+
+        synth_run(proc, n, pid_base, &tick, 0);
+        synth_run(proc, n, pid_base, &tick, 1);
+
+        process_view_refresh(proc_model_clear(proc_model));
+        remove_tree(dir);
+        g_free(proc);
+        g_free(sys);
+        g_free(dir);
+    }
+    return 0;
 }
 
+/* ================= 命令行参数 ================= */
+static gboolean opt_headless = FALSE;
+static gchar* opt_format = NULL;
+static gchar* opt_output = NULL;
+static int opt_top = 0;
+static gboolean opt_bench_parsers = FALSE;
+static gboolean opt_bench_scan = FALSE;
+static gchar* opt_bench_ui = NULL;
+static gchar* opt_proc_root = NULL;
+static gchar* opt_sys_root = NULL;
+
+static GOptionEntry option_entries[] = {
+    { "headless", 0, 0, G_OPTION_ARG_NONE, &opt_headless, "不启动界面，把采样结果输出到标准输出或文件", NULL },
+    { "interval", 'i', 0, G_OPTION_ARG_DOUBLE, &flash_time, "采样间隔，单位秒，可以是小数，最小 0.1（默认 1）", "SEC" },
+    { "format", 'f', 0, G_OPTION_ARG_STRING, &opt_format, "无界面模式的输出格式：json 或 csv（默认 json）", "FMT" },
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &opt_output, "无界面模式的输出文件，追加写入（默认标准输出）", "FILE" },
+    { "top", 'n', 0, G_OPTION_ARG_INT, &opt_top, "无界面模式只输出 CPU 占用最高的 N 个进程", "N" },
+    { "scan-workers", 0, 0, G_OPTION_ARG_INT, &scan_workers, "扫描 /proc 的线程数（默认按 CPU 核数）", "N" },
+    { "fd-budget", 0, 0, G_OPTION_ARG_INT, &fd_cache_limit, "/proc 文件描述符缓存上限，只能低于默认值（默认为 RLIMIT_NOFILE 软上限的一半）", "N" },
+    { "record", 0, 0, G_OPTION_ARG_FILENAME, &opt_record, "把每轮快照录制到 FILE.000000 起的 mmap 段文件", "FILE" },
+    { "record-size", 0, 0, G_OPTION_ARG_INT, &record_size_mb, "每个录制段的大小，单位 MB（默认 64）", "MB" },
+    { "record-keep", 0, 0, G_OPTION_ARG_INT, &record_keep, "最多保留的录制段数（含正在写的段，至少 2），0 表示全部保留", "N" },
+    { "record-sync", 0, 0, G_OPTION_ARG_INT, &record_sync_secs, "录制文件 msync 的间隔，单位秒（默认 5）", "SEC" },
+    { "replay", 0, 0, G_OPTION_ARG_FILENAME, &opt_replay, "用录制文件代替 /proc 驱动界面（或无界面输出）", "FILE" },
+    { "replay-speed", 0, 0, G_OPTION_ARG_INT, &replay_speed, "回放倍速 1~100（默认 1）", "N" },
+    { "bench-ui", 0, 0, G_OPTION_ARG_FILENAME, &opt_bench_ui, "用录制文件测量列表更新、过滤、排序和绘制的耗时", "FILE" },
+    { "proc-root", 0, 0, G_OPTION_ARG_FILENAME, &opt_proc_root, "读取进程和系统信息的 proc 目录（默认 /proc）", "DIR" },
+    { "sys-root", 0, 0, G_OPTION_ARG_FILENAME, &opt_sys_root, "读取 CPU 频率等信息的 sys 目录（默认 /sys）", "DIR" },
+    { "bench-synth", 0, 0, G_OPTION_ARG_NONE, &opt_bench_synth, "在合成的 /proc 上测量 1k/10k/100k 进程时每轮的耗时和分配次数（分配次数需要 -DMONITOR_COUNT_ALLOCS 构建）", NULL },
+    { "synth-procs", 0, 0, G_OPTION_ARG_INT, &synth_procs, "合成基准只测 N 个进程", "N" },
+    { "bench-parsers", 0, 0, G_OPTION_ARG_NONE, &opt_bench_parsers, "对比手写解析器和 sscanf 的耗时", NULL },
+    { "bench-scan", 0, 0, G_OPTION_ARG_NONE, &opt_bench_scan, "用不同线程数扫描 /proc 并报告耗时", NULL },
+    { NULL }
+};
+
 /* ================= 主函数 ================= */
 int main(int argc, char* argv[])
 {
+    // 先解析自己的参数，无界面模式不调用 gtk_init；GTK 自己的参数留给 gtk_init
+    GError* error = NULL;
+    GOptionContext* context = g_option_context_new(NULL);
+    g_option_context_add_main_entries(context, option_entries, NULL);
+    g_option_context_set_ignore_unknown_options(context, TRUE);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        g_error_free(error);
+        return 1;
+    }
+    g_option_context_free(context);
+
+    if (flash_time < 0.1) flash_time = 0.1;
+
+    if (opt_proc_root) g_strlcpy(proc_root, opt_proc_root, sizeof(proc_root));
+    if (opt_sys_root) g_strlcpy(sys_root, opt_sys_root, sizeof(sys_root));
+
+    if (opt_bench_parsers)
+        return bench_parsers();
+    if (opt_bench_synth)
+        return bench_synth();
+    if (opt_bench_scan)
+        return bench_scan();
+    if (opt_bench_ui)
+        return bench_ui(opt_bench_ui);
+    if (opt_replay) {
+        replay = replay_open(opt_replay, replay_speed);
+        if (!replay) return 1;
+        replay->stop_at_end = opt_headless;
+        snapshot_source = &replay->src;
+    }
+    if (opt_record) {
+        recorder = recorder_open(opt_record, record_size_mb, record_keep, record_sync_secs);
+        if (!recorder) return 1;
+    }
+    if (opt_headless)
+        return run_headless(opt_format, opt_output, opt_top);
+
     gtk_init(&argc, &argv);
-    cpu_table = g_hash_table_new(g_direct_hash, g_direct_equal);
-    io_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+    proc_scan_init(scan_workers);
+    perf_history_init(&perf_history);
 
     GtkWidget* win = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    main_window = win;
     gtk_window_set_title(GTK_WINDOW(win), "Linux任务管理器");
     gtk_window_set_default_size(GTK_WINDOW(win), 900, 500);
     g_signal_connect(win, "destroy", G_CALLBACK(gtk_main_quit), NULL);
 
+    GtkWidget* vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_add(GTK_CONTAINER(win), vbox);
+
     GtkWidget* hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
-    gtk_container_add(GTK_CONTAINER(win), hbox);
+    gtk_box_pack_start(GTK_BOX(vbox), hbox, TRUE, TRUE, 0);
+
+    // 回放时在底部加进度条、暂停和倍速
+    if (replay) {
+        gtk_window_set_title(GTK_WINDOW(win), "Linux任务管理器 - 回放");
+        gtk_box_pack_end(GTK_BOX(vbox), create_replay_bar(), FALSE, FALSE, 5);
+    }
 
     /* ===== 面板选项 ===== */
     GtkWidget* stack = gtk_stack_new();
+    main_stack = stack;
     GtkWidget* left_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 5);
     gtk_widget_set_size_request(left_box, 150, -1); // 宽度加大到 220
     gtk_box_pack_start(GTK_BOX(hbox), left_box, FALSE, FALSE, 5);
@@ -1261,24 +6896,29 @@ int main(int argc, char* argv[])
     // 创建可点击行，增加字体大小和行高
     GtkWidget* row_process = create_clickable_row("进程", stack, "process");
     GtkWidget* row_performance = create_clickable_row("性能", stack, "performance");
+    GtkWidget* row_cgroup = create_clickable_row("服务", stack, "cgroup");
 
     // 设置行高度
     gtk_widget_set_size_request(row_process, -1, 40);     // 行高 60
     gtk_widget_set_size_request(row_performance, -1, 40); // 行高 60
+    gtk_widget_set_size_request(row_cgroup, -1, 40);
 
     // 设置字体更大
     GtkWidget* label_process = gtk_bin_get_child(GTK_BIN(row_process));
     GtkWidget* label_perf = gtk_bin_get_child(GTK_BIN(row_performance));
+    GtkWidget* label_cgroup = gtk_bin_get_child(GTK_BIN(row_cgroup));
 
     PangoAttrList* attrs = pango_attr_list_new();
     PangoAttribute* font_attr = pango_attr_size_new_absolute(28 * PANGO_SCALE); // 28px
     pango_attr_list_insert(attrs, font_attr);
     gtk_label_set_attributes(GTK_LABEL(label_process), attrs);
     gtk_label_set_attributes(GTK_LABEL(label_perf), attrs);
+    gtk_label_set_attributes(GTK_LABEL(label_cgroup), attrs);
     pango_attr_list_unref(attrs);
 
     gtk_list_box_insert(GTK_LIST_BOX(btn_list), row_process, -1);
     gtk_list_box_insert(GTK_LIST_BOX(btn_list), row_performance, -1);
+    gtk_list_box_insert(GTK_LIST_BOX(btn_list), row_cgroup, -1);
 
     gtk_box_pack_start(GTK_BOX(hbox), stack, TRUE, TRUE, 0);
 
@@ -1290,14 +6930,26 @@ int main(int argc, char* argv[])
     performance_panel = create_performance_panel();
     gtk_stack_add_named(GTK_STACK(stack), performance_panel, "performance");
 
-    g_timeout_add_seconds(flash_time, update_system_total, NULL);//总状态刷新计时器
-    g_timeout_add_seconds(flash_time, update_memory_info, NULL);//总内存刷新计时器
-    g_timeout_add_seconds(flash_time, update_disk_info, NULL); // 每秒调用一次刷新函数
+    // cgroup 面板，只在显示时遍历 /sys/fs/cgroup
+    gtk_stack_add_named(GTK_STACK(stack), create_cgroup_panel(), "cgroup");
+
+    // /proc 采集放到后台线程，主线程只负责把快照刷到界面上
+    g_thread_new("collector", collector_thread, NULL);
 
     // 默认显示进程面板
     gtk_stack_set_visible_child(GTK_STACK(stack), process_panel);
 
     gtk_widget_show_all(win);
+
+    // 页面切换、最小化和焦点变化时通知采集线程
+    g_signal_connect(stack, "notify::visible-child", G_CALLBACK(on_view_notify), NULL);
+    g_signal_connect(perf_stack, "notify::visible-child", G_CALLBACK(on_view_notify), NULL);
+    g_signal_connect(win, "notify::is-active", G_CALLBACK(on_view_notify), NULL);
+    g_signal_connect(win, "window-state-event", G_CALLBACK(on_view_event), NULL);
+    g_signal_connect(win, "map-event", G_CALLBACK(on_view_event), NULL);
+    g_signal_connect(win, "unmap-event", G_CALLBACK(on_view_event), NULL);
+    update_view_mask();
+
     gtk_main();
 
     return 0;